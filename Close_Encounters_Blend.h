@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------------
+// Close_Encounters_Blend.h
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Row blending kernels for the Close Encounters Mothership Scanner. These
+// take the darkness values of the current row and the following row of a
+// pattern, and blend them together into the white channel of the slit array,
+// which is how the scanner gets its subpixel antialiasing. The blend is:
+//
+//   white = ((next * blendWeight) >> 8) + ((this * (256 - blendWeight)) >> 8)
+//
+// On the Arduino this is done one column at a time. On processors which have
+// SIMD instructions (SSE2 or AVX2 on a PC, NEON on ARM), the same math is done
+// on 16 columns at a time, and the results are bit-identical to the one
+// column at a time version.
+//
+// The SIMD versions write whole CRGBW pixels, with the red, green and blue
+// channels set to zero. That is fine for the slit array, since the scanner
+// only ever uses the white channel of the slit; the colored conversation
+// flashes are painted onto the strand afterwards.
+// ---------------------------------------------------------------------------
+#ifndef Close_Encounters_Blend_h
+#define Close_Encounters_Blend_h
+
+// Pick the widest SIMD instruction set that the compiler has been told it can
+// use. Define CE3K_BLEND_SIMD_OFF before including this file to force the one
+// column at a time version everywhere.
+#if defined(CE3K_BLEND_SIMD_OFF)
+  #define CE3K_BLEND_KERNEL "scalar"
+#elif defined(__AVX2__)
+  #include <immintrin.h>
+  #define CE3K_BLEND_AVX2
+  #define CE3K_BLEND_KERNEL "AVX2"
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define CE3K_BLEND_SSE2
+  #define CE3K_BLEND_KERNEL "SSE2"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define CE3K_BLEND_NEON
+  #define CE3K_BLEND_KERNEL "NEON"
+#else
+  #define CE3K_BLEND_KERNEL "scalar"
+#endif
+
+// ---------------------------------------------------------------------------
+// One column at a time version. This is what runs on the Arduino, and it is
+// also used for the leftover columns at the end of a row in the SIMD versions.
+// ---------------------------------------------------------------------------
+inline void blendSlitRowsScalar(const uint8_t* thisRow, const uint8_t* nextRow, uint8_t blendWeight, CRGBW* slit, uint16_t count)
+{
+  // Integer-math version of the blend: multiply by the blend weight into a
+  // 16-bit integer and then bitshift it back down to 8 bits.
+  uint16_t thisWeight = 256 - blendWeight;
+  while (count--)
+  {
+    (slit++)->white = (((uint16_t)*(nextRow++) * blendWeight) >> 8) + (((uint16_t)*(thisRow++) * thisWeight) >> 8);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Blend a whole row, using the SIMD version if there is one.
+// ---------------------------------------------------------------------------
+inline void blendSlitRows(const uint8_t* thisRow, const uint8_t* nextRow, uint8_t blendWeight, CRGBW* slit, uint16_t count)
+{
+#if defined(CE3K_BLEND_AVX2)
+  // Sixteen columns per multiply: widen the bytes to 16-bit lanes, do both
+  // multiplies and shifts, then widen the 8-bit results to 32-bit pixels with
+  // the value in the top byte, which is where the white channel of a CRGBW
+  // pixel sits in memory.
+  const __m256i nextWeight = _mm256_set1_epi16(blendWeight);
+  const __m256i thisWeight = _mm256_set1_epi16(256 - blendWeight);
+  while (count >= 16)
+  {
+    __m256i thisWide = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)thisRow));
+    __m256i nextWide = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)nextRow));
+    __m256i blended  = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(nextWide, nextWeight), 8),
+                                        _mm256_srli_epi16(_mm256_mullo_epi16(thisWide, thisWeight), 8));
+    __m256i low  = _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(blended)), 24);
+    __m256i high = _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(blended, 1)), 24);
+    _mm256_storeu_si256((__m256i*)slit, low);
+    _mm256_storeu_si256((__m256i*)(slit + 8), high);
+    thisRow += 16; nextRow += 16; slit += 16; count -= 16;
+  }
+#elif defined(CE3K_BLEND_SSE2)
+  // Sixteen columns per loop, eight per multiply. The 16-bit results are
+  // shifted into the top byte of each lane, and then interleaved with zeros
+  // to make 32-bit pixels with the value in the white channel.
+  const __m128i zero       = _mm_setzero_si128();
+  const __m128i nextWeight = _mm_set1_epi16(blendWeight);
+  const __m128i thisWeight = _mm_set1_epi16(256 - blendWeight);
+  while (count >= 16)
+  {
+    __m128i thisBytes = _mm_loadu_si128((const __m128i*)thisRow);
+    __m128i nextBytes = _mm_loadu_si128((const __m128i*)nextRow);
+    __m128i blendedLow  = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(nextBytes, zero), nextWeight), 8),
+                                        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(thisBytes, zero), thisWeight), 8));
+    __m128i blendedHigh = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(nextBytes, zero), nextWeight), 8),
+                                        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(thisBytes, zero), thisWeight), 8));
+    blendedLow  = _mm_slli_epi16(blendedLow, 8);
+    blendedHigh = _mm_slli_epi16(blendedHigh, 8);
+    _mm_storeu_si128((__m128i*)(slit),      _mm_unpacklo_epi16(zero, blendedLow));
+    _mm_storeu_si128((__m128i*)(slit + 4),  _mm_unpackhi_epi16(zero, blendedLow));
+    _mm_storeu_si128((__m128i*)(slit + 8),  _mm_unpacklo_epi16(zero, blendedHigh));
+    _mm_storeu_si128((__m128i*)(slit + 12), _mm_unpackhi_epi16(zero, blendedHigh));
+    thisRow += 16; nextRow += 16; slit += 16; count -= 16;
+  }
+#elif defined(CE3K_BLEND_NEON)
+  // Sixteen columns per loop. NEON multiplies 8-bit by 8-bit into 16-bit, so
+  // the (256 - blendWeight) multiply is done as (this << 8) - (this * weight),
+  // which gives the same result without needing a 9-bit weight. The final
+  // store interleaves the results with zeros into the g, r, b, w channels.
+  const uint8x8_t  weight = vdup_n_u8(blendWeight);
+  const uint8x16_t zero   = vdupq_n_u8(0);
+  while (count >= 16)
+  {
+    uint8x16_t thisBytes = vld1q_u8(thisRow);
+    uint8x16_t nextBytes = vld1q_u8(nextRow);
+    uint16x8_t nextLow   = vshrq_n_u16(vmull_u8(vget_low_u8(nextBytes), weight), 8);
+    uint16x8_t nextHigh  = vshrq_n_u16(vmull_u8(vget_high_u8(nextBytes), weight), 8);
+    uint16x8_t thisLow   = vshrq_n_u16(vsubq_u16(vshll_n_u8(vget_low_u8(thisBytes), 8),  vmull_u8(vget_low_u8(thisBytes), weight)), 8);
+    uint16x8_t thisHigh  = vshrq_n_u16(vsubq_u16(vshll_n_u8(vget_high_u8(thisBytes), 8), vmull_u8(vget_high_u8(thisBytes), weight)), 8);
+    uint8x16x4_t pixels;
+    pixels.val[0] = zero;
+    pixels.val[1] = zero;
+    pixels.val[2] = zero;
+    pixels.val[3] = vcombine_u8(vmovn_u16(vaddq_u16(nextLow, thisLow)), vmovn_u16(vaddq_u16(nextHigh, thisHigh)));
+    vst4q_u8((uint8_t*)slit, pixels);
+    thisRow += 16; nextRow += 16; slit += 16; count -= 16;
+  }
+#endif
+
+  // Whatever is left over (or the whole row, if there is no SIMD version).
+  blendSlitRowsScalar(thisRow, nextRow, blendWeight, slit, count);
+}
+
+#endif
@@ -19,13 +19,14 @@
 //
 //                    https://bit.ly/CE3K-Scanner
 //
-// Special note: This code is intended for use with CRGBW LED strips. Note
-// the "W" at the end of the "CRGBW". This means that the strips have red,
-// green, and blue LEDS, but also include a white LED too. I am using "BTF"
-// brand SK6812 RGBW strips (https://www.amazon.com/dp/B079ZW1265), but any
-// brand will work. I'm deliberately taking advantage of the separation of RGB
-// from W in my code, but it should be relatively simple to refactor this code
-// to work with regular CRGB strips, if that's what you're using.
+// Special note: This code was written for CRGBW LED strips. Note the "W" at
+// the end of the "CRGBW". This means that the strips have red, green, and blue
+// LEDS, but also include a white LED too. I am using "BTF" brand SK6812 RGBW
+// strips (https://www.amazon.com/dp/B079ZW1265), but any brand will work. I'm
+// deliberately taking advantage of the separation of RGB from W in my code.
+// Regular CRGB strips work too: declare the "leds" array as CRGB instead of
+// CRGBW, and the code picks the matching pixel math when it is compiled. See
+// CE3KpixelOps below for the details.
 // ---------------------------------------------------------------------------
 #ifndef Close_Encounters_Mothership_Scanner_h
 #define Close_Encounters_Mothership_Scanner_h
@@ -48,6 +49,16 @@
 #define SCANNER_BRIGHTNESS             150
 #define CONVERSATION_BRIGHTNESS        255
 
+// Gamma curve applied to the white scanner bars. The patterns, and the
+// subpixel blending between their rows, are in "perceptual" brightness
+// units, where 128 is meant to look about half as bright as 255. LEDs don't
+// work that way: the lowest brightness level of an LED is significantly
+// brighter than when the LED is just "off", and half the PWM value looks much
+// more than half as bright. A lookup table, built once at startup, converts
+// each blended slit pixel from perceptual units into the LED value, topping
+// out at SCANNER_BRIGHTNESS. Set this to 1.0 for the old purely linear blend.
+#define SCANNER_GAMMA                  2.2
+
 // Number of milliseconds between "frames" of the scanner light animation. For
 // reference, a 60fps video game displays at about 16ms per frame.
 #define SCANNER_ANIMATION_SPEED        15
@@ -74,16 +85,194 @@
 #define CONVERSATION_FLASH_MIN_FRAMES  5   // Minimum random width of color bar for each color flash animation (pixels). 
 #define CONVERSATION_FLASH_MAX_FRAMES  25  // Max is actually this plus the Minumum, for the total maximum.
 #define CONVERSATION_EXTRA_DWELL_MAX   40  // The color flashes dwell a random amount of frames at full extension during held notes (max random frames).
-#define CONVERSATION_FLASH_SPEED       13  // Minimum number of milliseconds before a new color flash animation frame can be played. If this is lower than the number of milliseconds the entire routine takes to run, it makes no difference.
+#define CONVERSATION_FLASH_SPEED       13  // Number of milliseconds per color flash animation frame. When a scanner frame runs late, the missed color flash frames are caught up, so the flashes keep this speed.
 #define CONVERSATION_FLASH_FRAMESKIP   3   // If the color flash animation swells too slowly, skip more frames to make it faster.
 #define CONVERSATION_FLASH_FREQUENCY   900 // Each blank frame, a random number of 0-1000 must exceed this number to start a new color flash (higher is less likely).
 
+// Number of color conversation flashes which can be animating at the same
+// time. In the film, there are some moments where several color flashes are
+// lit at once. The flashes are kept in a fixed-size pool, so the time spent
+// on the conversation animation stays bounded by this number, no matter how
+// busy the conversation gets. The default of 1 is the original behavior of
+// one color flash at a time; try 3 to get overlapping flashes like the film.
+#ifndef CONVERSATION_MAX_FLASHES
+#define CONVERSATION_MAX_FLASHES       1
+#endif
+
+// Soft, antialiased ends on the color conversation bars. The bars swell and
+// unswell by several pixels per color flash animation frame, which makes the
+// ends of the bars look steppy. With CONVERSATION_SOFT_EDGES turned on, the
+// length of each bar is instead drawn partway between its length on the
+// previous animation frame and on the current one, according to how much of
+// CONVERSATION_FLASH_SPEED has passed, so the bars swell smoothly on every
+// scanner frame. That puts the bars one color flash animation frame behind
+// where they would be otherwise. The pixel at each end of a bar which is only
+// partly covered is lit at that fraction of the bar's brightness. The default
+// of 0 gives the original hard-edged bars, exactly as they always looked.
+#ifndef CONVERSATION_SOFT_EDGES
+#define CONVERSATION_SOFT_EDGES        0
+#endif
+
 // Values I'm using for some speed optimizations to avoid expensive
-// floating-point and division operations during the main loop. 
-const uint8_t MAX_SUBPIXELS = 40;       // Highest number of subpixels that we will scroll any of the patterns.
-uint8_t div256Table[MAX_SUBPIXELS];     // Speed-optimization lookup table for weighting of each sub-scroll of the pattern.
-uint16_t slitCopyFullRepeatsCount = 0;  // How many full, un-truncated slit pattern strips fit inside the total LED strip.
-uint16_t slitCopyRemainingLeds = 0;     // Number of leftover pixels need to be copied for the last remainder to fill the LED strip.
+// floating-point operations during the main loop. The table is only ever
+// read once it has been built, so it is shared by every scanner (see
+// CE3Kscanner below).
+uint8_t scannerGammaTable[256];         // Speed-optimization lookup table converting blended slit pixels into LED values (see SCANNER_GAMMA).
+bool    scannerGammaTableBuilt = false; // Set once the table has been built, by the first scanner to be set up.
+
+// Optional frame cache. The slit view of a pattern repeats exactly, once the
+// scroll has been through every row of both of its arrays (the least common
+// multiple of their heights). With the frame cache, the scrolling of a
+// pattern is rounded down to CE3K_FRAME_CACHE_STEPS evenly spaced blend steps
+// between each row and the next, so that there is a fixed number of slit
+// views in the cycle, and each one is kept in the cache the first time it is
+// rendered. Once the scroll has been all the way through the cycle, each
+// frame is just a lookup plus the copy onto the strand. Nothing is rendered
+// in advance, so a pattern change takes no longer than any other frame.
+// CE3K_FRAME_CACHE_BYTES is the memory budget for the cache, in bytes, where
+// each cached frame takes one byte per column of the pattern. If the whole
+// cycle doesn't fit, then as much of the start of the cycle as fits is
+// cached, and the rest of the cycle is rendered live, rounded to the same
+// blend steps, so the show looks the same whatever the budget. Note that the
+// rounding is a visible change: with the cache on, the bars scroll in
+// CE3K_FRAME_CACHE_STEPS steps per row rather than smoothly, which at the
+// default of 16 steps is hard to see, but raise it if it shows on your
+// strand (each step costs one more frame of cache). Set this to 0 to turn
+// the cache off completely; that is the default, since the cycles of most
+// patterns are far too big for the RAM of an Arduino Mega. With
+// CE3K_FRAME_CACHE_REPORT turned on, the cache size and hit rate of each
+// pattern are printed to the serial port after the pattern changes, by
+// ce3kFrameCacheReport() in between frames (see the sketch).
+#ifndef CE3K_FRAME_CACHE_BYTES
+#define CE3K_FRAME_CACHE_BYTES   0
+#endif
+#ifndef CE3K_FRAME_CACHE_REPORT
+#define CE3K_FRAME_CACHE_REPORT  0
+#endif
+#ifndef CE3K_FRAME_CACHE_STEPS
+#define CE3K_FRAME_CACHE_STEPS   16
+#endif
+
+// Optional crossfade between patterns. Normally, when the scanner changes to
+// the next pattern, it cuts straight from one to the other. With
+// CE3K_PATTERN_CROSSFADE set to a number of milliseconds, the outgoing
+// pattern keeps scrolling for that long while it fades out, and the incoming
+// pattern fades in on top of it. Each pattern is rendered into its own
+// slit-sized buffer, and the two are blended together at slit width, before
+// the copy onto the strand, so the extra work during a crossfade depends on
+// the widths of the patterns rather than on the length of the strand. When
+// the two patterns have different widths, the blended slit is as wide as the
+// least common multiple of the two widths (or the whole strand, if that is
+// shorter), and the compiler sizes the slit arrays to fit the widest of the
+// crossfades in the pattern table. Set this to 0 for the original hard cut.
+#ifndef CE3K_PATTERN_CROSSFADE
+#define CE3K_PATTERN_CROSSFADE   0
+#endif
+
+// Optional zero-copy strand output. Normally, each scanner frame copies the
+// slit view onto every pixel of leds[], and the conversation flashes are then
+// painted on top of that copy, so the work done per frame grows with the
+// length of the strand. With CE3K_ZERO_COPY_OUTPUT turned on, leds[] is not
+// touched at all. Instead, the variable ce3kStrandFrame describes the strand
+// as "the slit array, repeated this many times, plus this many leftover
+// pixels", along with a short list of patches where conversation flashes are
+// lit. An LED driver which can walk that description while it clocks out the
+// data (see ce3kStreamStrand) never needs the full-length copy at all. The
+// stock FastLED controllers can only send from a full array, so if you turn
+// this on with them, call ce3kExpandStrand(leds) just before FastLED.show().
+#ifndef CE3K_ZERO_COPY_OUTPUT
+#define CE3K_ZERO_COPY_OUTPUT    0
+#endif
+
+// Graceful degradation when the processor can't keep up. If a frame starts so
+// late that a whole frame has been missed, for example on a very long strand
+// or a slow controller, the missed frames are dropped rather than played late,
+// and everything still moves at the right speed, since all of the animations
+// are advanced by the time that has actually passed. On top of that, once
+// CE3K_OVERLOAD_LATE_FRAMES frames have been late without a break of
+// CE3K_OVERLOAD_FRAMES on-time frames in a row between them, the scanner
+// skips the subpixel blending between rows, and only moves the bars in
+// whole-row steps. That way, frames in which the bars haven't moved a whole
+// row don't change the slit view, and skip the costly copy of the slit onto
+// the strand. A single late frame, for example while the serial port is
+// busy, doesn't count as being overloaded. The blending comes back after
+// CE3K_OVERLOAD_FRAMES on-time frames in a row. Set CE3K_OVERLOAD_FRAMES to
+// 0 to always blend, even when frames are being dropped.
+#ifndef CE3K_OVERLOAD_FRAMES
+#define CE3K_OVERLOAD_FRAMES       16
+#endif
+#ifndef CE3K_OVERLOAD_LATE_FRAMES
+#define CE3K_OVERLOAD_LATE_FRAMES  3
+#endif
+static_assert(CE3K_OVERLOAD_FRAMES <= 255, "CE3K Scanner: CE3K_OVERLOAD_FRAMES must be 255 or less.");
+static_assert(CE3K_OVERLOAD_LATE_FRAMES >= 1 && CE3K_OVERLOAD_LATE_FRAMES <= 255, "CE3K Scanner: CE3K_OVERLOAD_LATE_FRAMES must be from 1 to 255.");
+
+// Power estimate of each frame, for limiting the current drawn by the strand.
+// FastLED's own power limiter walks the whole LED array on every show() to
+// add up the current, and on a CRGBW strip it can't tell the white LEDs
+// apart from the colored ones. Most of the strand is just copies of the slit
+// view, though, so with CE3K_POWER_ESTIMATE turned on, the scanner adds up
+// the slit once when it changes, multiplies that up by the number of copies,
+// and adds the extra drawn by the conversation flashes, so the work depends
+// on the width of the pattern rather than the length of the strand. The
+// sketch then calls ce3kPowerBrightness() to get the brightness which keeps
+// the strand within its power supply, and hands it to FastLED.setBrightness(),
+// which scales the pixels while it sends them out. The power drawn by each
+// LED at full brightness is in milliwatts; the figures for red, green, blue
+// and dark LEDs are the same ones FastLED uses, and white is counted on its
+// own. Set CE3K_POWER_ESTIMATE to 0 to leave all of this out.
+#ifndef CE3K_POWER_ESTIMATE
+#define CE3K_POWER_ESTIMATE      1
+#endif
+#ifndef CE3K_POWER_RED_MW
+#define CE3K_POWER_RED_MW        80   // 16 mA at 5 volts.
+#endif
+#ifndef CE3K_POWER_GREEN_MW
+#define CE3K_POWER_GREEN_MW      55   // 11 mA at 5 volts.
+#endif
+#ifndef CE3K_POWER_BLUE_MW
+#define CE3K_POWER_BLUE_MW       75   // 15 mA at 5 volts.
+#endif
+#ifndef CE3K_POWER_WHITE_MW
+#define CE3K_POWER_WHITE_MW      100  // 20 mA at 5 volts.
+#endif
+#ifndef CE3K_POWER_DARK_MW
+#define CE3K_POWER_DARK_MW       5    // 1 mA at 5 volts, drawn by each LED even when it's off.
+#endif
+
+// Optional built-in profiler. With CE3K_PROFILE turned on, the time taken by
+// each stage of the hot loop (below) is recorded, and the sketch prints the
+// minimum, average, maximum and 99th percentile of each stage to the serial
+// port every few seconds, along with how many frames missed the
+// SCANNER_ANIMATION_SPEED deadline. See "Close_Encounters_Profiler.h" for the
+// details and the format of the report. Turned off, it compiles to nothing.
+// Its statistics are shared by every scanner, so it can't be used with
+// scanners running at the same time on different processor cores.
+#ifndef CE3K_PROFILE
+#define CE3K_PROFILE             0
+#endif
+
+// Optional timing hooks which mark the start and end of each stage of a
+// frame. Normally these compile to nothing. The profiler above fills them in,
+// and so does the host-side benchmark in the "extras/host" folder, which
+// defines them before including this file, so that it can measure how long
+// each stage of the hot loop takes.
+#define CE3K_STAGE_SLIT          0  // Assembling the slit view from the pattern arrays.
+#define CE3K_STAGE_COPY          1  // Copying the slit view onto the whole LED strand.
+#define CE3K_STAGE_CONVERSATION  2  // Painting the color conversation flashes.
+#define CE3K_STAGE_SHOW          3  // Sending the frame to the LED strip, in the sketch.
+#define CE3K_NUM_STAGES          4
+#if CE3K_PROFILE
+#include "Close_Encounters_Profiler.h"
+#else
+inline void ce3kProfileReport() {}
+#endif
+#ifndef CE3K_STAGE_BEGIN
+#define CE3K_STAGE_BEGIN(stage)
+#endif
+#ifndef CE3K_STAGE_END
+#define CE3K_STAGE_END(stage)
+#endif
 
 // ---------------------------------------------------------------------------
 // Pixel array definitions
@@ -104,10 +293,17 @@ uint16_t slitCopyRemainingLeds = 0;     // Number of leftover pixels need to be
 // top/bottom and sides. The code allows arrays of different heights in order
 // to help with being able to design wrap-around images.
 //
-// If new arrays have are added here, remember to also update the place at the
-// beginning of the ce3kScanner() function which defines the data structure of
-// each pattern, and also update the NUM_CE3K_PATTERNS and WIDEST_ARRAY
-// values.
+// If new arrays are added here, remember to also add a pattern which uses
+// them to the CE3Kpatterns table further down.
+//
+// The arrays below are stored as one byte per pixel, which makes them easy to
+// read and edit by hand. The running patterns use bit-packed copies of them
+// instead, which take up far less flash memory. The packed copies live in the
+// file "Close_Encounters_Packed_Patterns.h". If you edit or add an array here,
+// regenerate that file with the packer program in the "extras/host" folder.
+// Patterns drawn in an image editor can be converted straight from PGM files
+// into a header of arrays, in any of the storage formats, with the pattern
+// compiler in the same folder (extras/host/Compile_Patterns.cpp).
 // ---------------------------------------------------------------------------
 
 // Work in progress: I'm working on GitHub issue #8 - trying to allow for larger
@@ -129,8 +325,8 @@ uint16_t slitCopyRemainingLeds = 0;     // Number of leftover pixels need to be
 // that if, in a given pattern, you are using only one array instead of both
 // arrays, then supply this as the second array.
 const char PROGMEM arrayBlank[] = {};
-int  arrayBlankSize = sizeof(arrayBlank);
-int  arrayBlankWidth = 0;
+const int arrayBlankSize = sizeof(arrayBlank);
+const int arrayBlankWidth = 0;
 
 // Arrays Tony01 and Tony02, when combined together, create a particularly nice
 // and interesting pattern. Reminiscent of the film, but not the same as any of
@@ -161,8 +357,8 @@ const char PROGMEM arrayTony01[] =
   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
 };
-int arrayTony01Size = sizeof(arrayTony01);
-int arrayTony01Width = 44;
+const int arrayTony01Size = sizeof(arrayTony01);
+const int arrayTony01Width = 44;
 
 const char PROGMEM arrayTony02[] = 
 {
@@ -189,8 +385,8 @@ const char PROGMEM arrayTony02[] =
   1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,1,
   1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,1,1,
 };
-int arrayTony02Size = sizeof(arrayTony02);
-int arrayTony02Width = 44;
+const int arrayTony02Size = sizeof(arrayTony02);
+const int arrayTony02Width = 44;
 
 // Attempt to reproduce the counter-rotating pairs of lights, used for most of
 // the conversation scene, which seem to merge and split. This is a single
@@ -228,8 +424,48 @@ const char PROGMEM arrayConversationPairs[] =
   0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,
   0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,
 };
-int arrayConversationPairsSize = sizeof(arrayConversationPairs);
-int arrayConversationPairsWidth = 32;
+const int arrayConversationPairsSize = sizeof(arrayConversationPairs);
+const int arrayConversationPairsWidth = 32;
+
+// Antialiased, grayscale (CE3K_FORMAT_GRAY) version of the counter-rotating
+// pairs above. Each pixel is a brightness level from 0 (black) to 255 (fully
+// lit), so the edges of the bars can fall between pixels, the way the edges
+// of the film's cutouts fall between the fibers of the scanner ring.
+const uint8_t PROGMEM arrayConversationPairsGray[] = 
+{
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12,187,255,255,255,255,255,255,187, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 16,199,255,255,255,255,255,255,255,255,199, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0, 24,211,255,255,255,255,255,255,255,255,255,255,211, 24,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0, 32,219,255,255,255,255,255,131,131,255,255,255,255,255,219, 32,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0, 40,227,255,255,255,255,255,116,  0,  0,116,255,255,255,255,255,227, 40,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0, 48,235,255,255,255,255,255,100,  0,  0,  0,  0,100,255,255,255,255,255,235, 48,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0, 60,243,255,255,255,255,251, 84,  0,  0,  0,  0,  0,  0, 84,251,255,255,255,255,243, 60,  0,  0,  0,  0,  0,
+    0,  0,  0,  0, 72,247,255,255,255,255,247, 72,  0,  0,  0,  0,  0,  0,  0,  0, 72,247,255,255,255,255,247, 72,  0,  0,  0,  0,
+    0,  0,  0, 84,251,255,255,255,255,243, 60,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 60,243,255,255,255,255,251, 84,  0,  0,  0,
+    0,  0,100,255,255,255,255,255,235, 48,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 48,235,255,255,255,255,255,100,  0,  0,
+    0,116,255,255,255,255,255,227, 40,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 40,227,255,255,255,255,255,116,  0,
+  131,255,255,255,255,255,219, 32,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 32,219,255,255,255,255,255,131,
+  255,255,255,255,255,211, 24,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 24,211,255,255,255,255,255,
+  255,255,255,255,199, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 16,199,255,255,255,255,
+  255,255,255,187, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12,187,255,255,255,
+  255,255,255,187, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12,187,255,255,255,
+  255,255,255,255,199, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 16,199,255,255,255,255,
+  255,255,255,255,255,211, 24,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 24,211,255,255,255,255,255,
+  131,255,255,255,255,255,219, 32,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 32,219,255,255,255,255,255,131,
+    0,116,255,255,255,255,255,227, 40,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 40,227,255,255,255,255,255,116,  0,
+    0,  0,100,255,255,255,255,255,235, 48,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 48,235,255,255,255,255,255,100,  0,  0,
+    0,  0,  0, 84,251,255,255,255,255,243, 60,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 60,243,255,255,255,255,251, 84,  0,  0,  0,
+    0,  0,  0,  0, 72,247,255,255,255,255,247, 72,  0,  0,  0,  0,  0,  0,  0,  0, 72,247,255,255,255,255,247, 72,  0,  0,  0,  0,
+    0,  0,  0,  0,  0, 60,243,255,255,255,255,251, 84,  0,  0,  0,  0,  0,  0, 84,251,255,255,255,255,243, 60,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0, 48,235,255,255,255,255,255,100,  0,  0,  0,  0,100,255,255,255,255,255,235, 48,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0, 40,227,255,255,255,255,255,116,  0,  0,116,255,255,255,255,255,227, 40,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0, 32,219,255,255,255,255,255,131,131,255,255,255,255,255,219, 32,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0, 24,211,255,255,255,255,255,255,255,255,255,255,211, 24,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 16,199,255,255,255,255,255,255,255,255,199, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12,187,255,255,255,255,255,255,187, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+const int arrayConversationPairsGraySize = sizeof(arrayConversationPairsGray);
+const int arrayConversationPairsGrayWidth = 32;
 
 // Another set of two overlaid patterns of my own (not in the film).
 const char PROGMEM arrayTony03[] = 
@@ -245,8 +481,8 @@ const char PROGMEM arrayTony03[] =
   0,1,1,1,1,1,1,0,0,0,0,0,0,0,0,1,1,1,1,1,
   0,0,1,1,1,1,1,1,0,0,0,0,0,0,1,1,1,1,1,1,
 };
-int arrayTony03Size = sizeof(arrayTony03);
-int arrayTony03Width = 20;
+const int arrayTony03Size = sizeof(arrayTony03);
+const int arrayTony03Width = 20;
 
 const char PROGMEM arrayTony04[] = 
 {
@@ -273,658 +509,2493 @@ const char PROGMEM arrayTony04[] =
   0,0,0,1,1,1,1,1,1,0,0,0,0,1,1,1,1,1,1,0,
   0,0,0,0,1,1,1,1,1,1,0,0,0,0,1,1,1,1,1,1,
 };
-int arrayTony04Size = sizeof(arrayTony04);
-int arrayTony04Width = 20;
-
-// Define the widest array width that is expected to be used in the code. It
-// should be the widest of the arrays defined above.
-#define WIDEST_ARRAY 44
+const int arrayTony04Size = sizeof(arrayTony04);
+const int arrayTony04Width = 20;
 
-// This is an array of values that represents the "slit" view of the zigzag
-// patterns. Note: This code was written for CRGBW strip hardware; if you are
-// using CRGB hardware, you'll need to refactor some parts of this code.
-CRGBW zigzagSlit[WIDEST_ARRAY];
+// Storage formats for the pixel arrays. Both arrays in a running pattern must
+// use the same format.
+//
+// CE3K_FORMAT_BYTES:  One byte per pixel, 0 or 1, as in the arrays above.
+//
+// CE3K_FORMAT_PACKED: One bit per pixel. Each row of the pattern is stored as
+//                     one or more 32-bit words, with the leftmost pixel in
+//                     the lowest bit, and each row starts on a fresh word.
+//                     This is up to 8x smaller than the byte format, and it
+//                     lets the code AND together 32 pixels of the two arrays
+//                     at a time. The array size must be a whole number of
+//                     rows, and the size is still counted in pixels.
+//
+// CE3K_FORMAT_GRAY:   One byte per pixel, a brightness level from 0 to 255.
+//                     Two grayscale arrays are combined by multiplying them
+//                     together rather than ANDing them, so a half-transparent
+//                     pixel over another half-transparent pixel lets through
+//                     a quarter of the light.
+//
+// CE3K_FORMAT_RLE:    Run-length encoded, one bit per pixel. The array starts
+//                     with a small row index, one 16-bit little-endian byte
+//                     offset per row, pointing at that row's runs. Each row is
+//                     a list of one-byte run lengths, alternating between dark
+//                     and lit pixels, starting with dark (a row which starts
+//                     lit begins with a run of 0). A run of more than 255 is
+//                     written as 255, 0, and then the rest. The zigzag cutouts
+//                     are mostly long runs of the same value, so tall, wide
+//                     patterns take up far less flash this way, and decoding a
+//                     row costs one step per run rather than one per pixel.
+//                     The array size must be a whole number of rows, and the
+//                     size is still counted in pixels.
+#define CE3K_FORMAT_BYTES   0
+#define CE3K_FORMAT_PACKED  1
+#define CE3K_FORMAT_GRAY    2
+#define CE3K_FORMAT_RLE     3
+
+// Bit-packed and run-length copies of the arrays above, generated by the
+// packer program.
+#include "Close_Encounters_Packed_Patterns.h"
 
+// ---------------------------------------------------------------------------
+// Pattern table
+// ---------------------------------------------------------------------------
 // Define a data structure called "CE3Kpattern", which holds the collected
 // information for one of the currently-running patterns. Note that a running
 // pattern can be a combination of up to two of the image arrays defined
 // above.
 // 
-// A note about the SubpixelResolution parameter: This code will scroll the view
-// of a "slit" down the zigzag pattern images. It will do so in units which are
+// A note about the Speed parameter: This code will scroll the view of a
+// "slit" down the zigzag pattern images. It will do so in units which are
 // smaller than one line, in order to get sub-pixel resolution of the movement
-// of the image. This variable controls the number of "steps" which will occur
-// between each line of the image. The finer the subpixel resolution (the larger
-// this variable is), then the greater number of steps, so the slower that the
-// simulation will scroll that pattern. In this way, SubpixelResolution is what
-// controls the relative "speed" of the white bars during each pattern. Note
-// that this code is only doing subpixel resolution in the vertical dimension,
-// not horizontal, so all antialiasing occurs vertically line-to-line, not
-// sideways pixel-to-pixel.
+// of the image. The scroll position is a 16.16 fixed-point number of rows:
+// the top 16 bits are the row, and the next 8 bits below that are the blend
+// weight between that row and the following one. Speed is how many rows the
+// scroll position moves per millisecond, in the same 16.16 format, and it is
+// what controls the relative "speed" of the white bars during each pattern.
+// Use the CE3K_ROWS_PER_SECOND macro to set it. Since the scroll position is
+// moved by the actual time elapsed since the last frame, the bars keep the
+// same speed even if some frames run late. Note that this code is only doing
+// subpixel resolution in the vertical dimension, not horizontal, so all
+// antialiasing occurs vertically line-to-line, not sideways pixel-to-pixel.
 typedef struct
 {
-  char* ArrayA;             // Can use up to two overlapping arrays if desired.
-  char* ArrayB;             // If using only one array, set this to arrayBlank.
-  int   SizeA;  
-  int   SizeB;    
-  int   Width;              // If using two arrays, they must both be the same width. 
-  int   SubpixelResolution; // Indirectly controls the speed of the white bars.
+  const void* ArrayA;             // Can use up to two overlapping arrays if desired.
+  const void* ArrayB;             // If using only one array, set this to arrayBlank.
+  int         SizeA;              // Size of each array in pixels (not bytes).
+  int         SizeB;    
+  int         Width;              // If using two arrays, they must both be the same width. 
+  uint32_t    Speed;              // Controls the speed of the white bars, see CE3K_ROWS_PER_SECOND.
+  uint8_t     Format;             // Storage format of both arrays, one of the CE3K_FORMAT values.
 } CE3Kpattern;
 
-// Variable which indicates how many total runnable patterns are going to be
-// used in this program. Note: here, we are talking about the sets of data
-// structures which contain the runnable patterns, not the pixel arrays defined
-// above. If changing the number of patterns in the program, first update the
-// definitions at the beginning of the ce3kScanner() function which update the
-// pattern data structures, then update this number to match.
-#define NUM_CE3K_PATTERNS 3
+// Convert a scroll speed in rows per second into the 16.16 rows per
+// millisecond of CE3Kpattern.Speed. For reference, the scanner used to move
+// in fixed steps of one fifth of a row per 15ms frame, which is 13.33 rows
+// per second.
+#define CE3K_ROWS_PER_SECOND(rows) ((uint32_t)((rows) * 65536.0 / 1000.0 + 0.5))
+
+// The table of all of the runnable patterns, which the scanner cycles through
+// in order. Note: here, we are talking about the data structures which
+// contain the runnable patterns, not the pixel arrays defined above. To add a
+// pattern, just add a line to this table. Everything that depends on the
+// table (the number of patterns, the width of the widest pattern, and so the
+// size of the slit arrays) is worked out from it by the compiler, and the
+// compiler also checks each entry, so a mistake in the table is an error at
+// compile time rather than something to find on the serial port. The table
+// itself lives in flash memory (PROGMEM). Only the pattern which is currently
+// running gets copied into RAM, see activatePattern().
+//
+// The antialiased grayscale version of the conversation pairs is left out of
+// the show unless CE3K_GRAY_PATTERN is turned on, so the show is the same
+// three patterns as it always was. Turn it on to try the grayscale format.
+#ifndef CE3K_GRAY_PATTERN
+#define CE3K_GRAY_PATTERN 0
+#endif
+constexpr CE3Kpattern CE3Kpatterns[] PROGMEM =
+{
+  // ArrayA                      ArrayB             SizeA                             SizeB                  Width                              Speed                        Format
+  { arrayTony01Rle,               arrayTony02Rle,    arrayTony01RleSize,               arrayTony02RleSize,    arrayTony01RleWidth,               CE3K_ROWS_PER_SECOND(13.33), CE3K_FORMAT_RLE    },
+  { arrayTony03Packed,            arrayTony04Packed, arrayTony03PackedSize,            arrayTony04PackedSize, arrayTony03PackedWidth,            CE3K_ROWS_PER_SECOND(4.44),  CE3K_FORMAT_PACKED },
+  { arrayConversationPairsPacked, arrayBlank,        arrayConversationPairsPackedSize, arrayBlankSize,        arrayConversationPairsPackedWidth, CE3K_ROWS_PER_SECOND(13.33), CE3K_FORMAT_PACKED },
+#if CE3K_GRAY_PATTERN
+  { arrayConversationPairsGray,   arrayBlank,        arrayConversationPairsGraySize,   arrayBlankSize,        arrayConversationPairsGrayWidth,   CE3K_ROWS_PER_SECOND(13.33), CE3K_FORMAT_GRAY   },
+#endif
+};
 
-// Define an array to hold all of the data structures of all of the runnable
-// patterns. At the start of the main loop, values will be assigned to the data
-// structures in this array. Then we will be able to cycle through all of the
-// patterns.
-CE3Kpattern CE3Kpatterns[NUM_CE3K_PATTERNS];
+// Number of patterns in the table above.
+constexpr int NUM_CE3K_PATTERNS = sizeof(CE3Kpatterns) / sizeof(CE3Kpatterns[0]);
 
-// Number of milliseconds between pattern changes.
-#define CE3K_PATTERN_CHANGE_INTERVAL 15000
+// Compile-time helpers which look through the table above. These are only
+// ever run by the compiler, never on the Arduino.
+constexpr int ce3kLarger(int a, int b) { return (a > b) ? a : b; }
+
+constexpr int ce3kWidestPattern(int index)
+{
+  return (index >= NUM_CE3K_PATTERNS) ? 0 : ce3kLarger(CE3Kpatterns[index].Width, ce3kWidestPattern(index + 1));
+}
+
+constexpr int ce3kNarrowestPattern(int index)
+{
+  return (index >= NUM_CE3K_PATTERNS) ? 0x7FFF :
+         (CE3Kpatterns[index].Width < ce3kNarrowestPattern(index + 1)) ? CE3Kpatterns[index].Width : ce3kNarrowestPattern(index + 1);
+}
+
+// Each pattern needs a width, a known format, and, for the packed and
+// grayscale formats, arrays which are a whole number of rows tall.
+constexpr bool ce3kPatternIsValid(const CE3Kpattern& pattern)
+{
+  return (pattern.Width > 0) &&
+         (pattern.Format <= CE3K_FORMAT_RLE) &&
+         (pattern.Format == CE3K_FORMAT_BYTES || (pattern.SizeA % pattern.Width == 0 && pattern.SizeB % pattern.Width == 0));
+}
+
+constexpr bool ce3kPatternsAreValid(int index)
+{
+  return (index >= NUM_CE3K_PATTERNS) || (ce3kPatternIsValid(CE3Kpatterns[index]) && ce3kPatternsAreValid(index + 1));
+}
+
+// The width of the widest pattern, which sets the size of the row arrays.
+constexpr int WIDEST_ARRAY = ce3kWidestPattern(0);
+
+// The most frames that the frame cache can ever hold, which is for the
+// narrowest pattern (see CE3K_FRAME_CACHE_BYTES).
+#if CE3K_FRAME_CACHE_BYTES > 0
+constexpr long CE3K_FRAME_CACHE_MAX_FRAMES = CE3K_FRAME_CACHE_BYTES / ce3kNarrowestPattern(0);
+#endif
+
+// The width of the slit view which gets copied onto the strand. This is the
+// widest pattern, unless a crossfade between two of the patterns needs more.
+#if CE3K_PATTERN_CROSSFADE > 0
+constexpr long ce3kGreatestCommonDivisor(long a, long b) { return (b == 0) ? a : ce3kGreatestCommonDivisor(b, a % b); }
 
+constexpr long ce3kCrossfadeWidth(long a, long b)
+{
+  return ((a / ce3kGreatestCommonDivisor(a, b)) * b < NUM_LEDS) ? (a / ce3kGreatestCommonDivisor(a, b)) * b : NUM_LEDS;
+}
+
+constexpr long ce3kWidestCrossfade(int index)
+{
+  return (index >= NUM_CE3K_PATTERNS) ? 0 :
+         ce3kLarger(ce3kCrossfadeWidth(CE3Kpatterns[index].Width, CE3Kpatterns[(index + 1) % NUM_CE3K_PATTERNS].Width), ce3kWidestCrossfade(index + 1));
+}
+
+constexpr int SLIT_ARRAY_WIDTH = ce3kLarger(WIDEST_ARRAY, ce3kWidestCrossfade(0));
+#else
+constexpr int SLIT_ARRAY_WIDTH = WIDEST_ARRAY;
+#endif
+
+static_assert(NUM_CE3K_PATTERNS > 0, "CE3K Scanner: the CE3Kpatterns table is empty.");
+static_assert(ce3kPatternsAreValid(0), "CE3K Scanner: a pattern in the CE3Kpatterns table has a bad width, format or array size.");
+
+// Pixel type of the LED strand, taken from the declaration of the "leds"
+// array in the sketch, so that there's nothing to configure: a sketch with
+// "CRGBW leds[NUM_LEDS]" gets the CRGBW code, and one with "CRGB leds[NUM_LEDS]"
+// gets the CRGB code. The choice is made by the compiler, so neither version
+// of the code has any runtime checks of which kind of strip it is running.
+template <typename ARRAY> struct CE3KstrandArray;
+template <typename PIXEL, size_t COUNT> struct CE3KstrandArray<PIXEL[COUNT]> { typedef PIXEL Pixel; };
+typedef CE3KstrandArray<decltype(leds)>::Pixel CE3KledPixel;
+
+// Row blending math, including SIMD versions for processors which have them.
+#include "Close_Encounters_Blend.h"
 
 // ---------------------------------------------------------------------------
-// Function to grab one pixel out of the zigzag pixel array(s), and turn it
-// into a brightness value that can be applied to the LEDs.
+// Pixel math which depends on the type of LED strip. There is one version of
+// CE3KpixelOps for each supported pixel type, and the code below always uses
+// CE3KpixelOps<CE3KledPixel>, so only the version for the strip in use is
+// compiled. Each version provides:
+//
+//   blendRows() - Blends slitThisRow and slitNextRow into the slit array,
+//                 through the SCANNER_GAMMA table, as the white scanner bars.
+//   setWhite()  - Sets a slit pixel to a white scanner value.
+//   getWhite()  - Gets the white scanner value back out of a slit pixel.
+//   paint()     - Builds a strand pixel which has a conversation flash color
+//                 on top of the slit pixel underneath it.
+//   power()     - Power drawn by a pixel, in 1/256ths of a milliwatt, see
+//                 CE3K_POWER_ESTIMATE.
+//   fillSpan()  - Paints a conversation flash color onto a run of strand
+//                 pixels, the same as paint() on each of them.
+//   eraseSpan() - Sets a run of strand pixels back to the slit underneath.
+//
+// The span functions take the column of the slit under the first pixel of
+// the run, and the width of the slit, and wrap around it along the run.
 // ---------------------------------------------------------------------------
-int pixelValue(long arrayPosition, char firstArray[], int firstArraySize, char secondArray[], int secondArraySize)
+template <typename PIXEL> struct CE3KpixelOps;
+
+// CRGBW strips: the scanner uses only the white LEDs, and the conversation
+// flashes only the RGB LEDs, so the two animations never have to be blended
+// together; the LEDs themselves add up the light.
+template <> struct CE3KpixelOps<CRGBW>
 {
-  // Work in progress: I'm working on GitHub issue #8 - trying to allow for
-  // larger patterns with proper antialiasing. Originally the pixel arrays were
-  // coded as bool, either 0 or 1, to make it easier to type patterns into the
-  // arrays. This is in-process of being changed, so that each pixel in the
-  // pattern could be an 8 bit level which can be antialiased.
-  // 
-  // Current state: If you are using two arrays, this code ANDs the two arrays
-  // together so that any black stripes are preserved. This simulates the
-  // original fiber optic effect, where the photosensor controlling the fiber
-  // optic light is blocked by the pattern(s).  
-  static long lastPosition = -1;
-  static int index1 = 0;
-  static int index2 = 0;
+  static inline void blendRows(const uint8_t* thisRow, const uint8_t* nextRow, uint8_t blendWeight, CRGBW* slit, uint16_t count)
+  {
+    // The blend itself is done with the SIMD kernels, where there are any,
+    // and then the gamma table is applied to the white channel in place.
+    blendSlitRows(thisRow, nextRow, blendWeight, slit, count);
+    while (count--)
+    {
+      slit->white = scannerGammaTable[slit->white];
+      slit++;
+    }
+  }
 
-  // Speed optimization: Handle the first run or frame reset (Position 0).
-  // Previously it did an expensive modulo calculation ("%") every time this
-  // function was called. Now it only does the modulo on the first pixel of a
-  // frame, improving the overall speed. 
-  //
-  // Each array will be smaller than the arrayPosition variable, but by using
-  // the modulo operator (%) we can dig into the arrays at the correct
-  // position points without needing complicated math. Basically, the
-  // arrayPosition cycles continuously through a very large range of numbers,
-  // and the "%" operator is the math that finds out what the array position
-  // would have been if it had started within this small array. This allows
-  // the code to support zigzag arrays of any size.
-  //
-  // The speed optimization is to only calculate the modulo at certain points
-  // where it's needed, and use normal integer addition and subtraction
-  // most of the rest of the time.
-  long difference = arrayPosition - lastPosition;
-  if (lastPosition == -1 || arrayPosition == 0 || difference == arrayPosition) 
+  static inline void    setWhite(CRGBW& pixel, uint8_t white) { pixel.white = white; }
+  static inline uint8_t getWhite(const CRGBW& pixel)          { return pixel.white; }
+
+  static inline void paint(CRGBW& pixel, const CRGBW& slit, const CRGB& color)
+  {
+    pixel.red   = color.red;
+    pixel.green = color.green;
+    pixel.blue  = color.blue;
+    pixel.white = slit.white;
+  }
+
+  static inline uint32_t power(const CRGBW& pixel)
   {
-    // Also cast the modulo operations to unsigned ints to speed those up.     
-    index1 = (unsigned long)arrayPosition % (unsigned int)firstArraySize;
-    if (secondArraySize > 0)
+    return ((uint32_t)pixel.red   * CE3K_POWER_RED_MW)  + ((uint32_t)pixel.green * CE3K_POWER_GREEN_MW) +
+           ((uint32_t)pixel.blue  * CE3K_POWER_BLUE_MW) + ((uint32_t)pixel.white * CE3K_POWER_WHITE_MW);
+  }
+
+  // The white channel of the strand is already the slit, and the RGB of the
+  // slit is always zero, so the spans only touch RGB, and never need the slit.
+  static inline void fillSpan(CRGBW* pixels, const CRGBW* /*slit*/, uint16_t /*column*/, uint16_t /*width*/, uint16_t count, const CRGB& color)
+  {
+    while (count--)
     {
-      index2 = (unsigned long)arrayPosition % (unsigned int)secondArraySize;
+      pixels->red   = color.red;
+      pixels->green = color.green;
+      pixels->blue  = color.blue;
+      pixels++;
     }
   }
-  else 
+
+  static inline void eraseSpan(CRGBW* pixels, const CRGBW* /*slit*/, uint16_t /*column*/, uint16_t /*width*/, uint16_t count)
   {
-    // For all subsequent pixels in the row, use addition/subtraction instead of
-    // expensive modulo operations.
+    while (count--)
+    {
+      pixels->red   = 0;
+      pixels->green = 0;
+      pixels->blue  = 0;
+      pixels++;
+    }
+  }
+};
 
-    // Update tracking for the first array.
-    index1 += (int)difference;
-    while (index1 >= firstArraySize) index1 -= firstArraySize;
-    while (index1 < 0)               index1 += firstArraySize;
-    
-    // Update tracking for the second array (if a second array is used).
-    if (secondArraySize > 0)
+// CRGB strips: the white scanner bars are shown as gray RGB values, and the
+// conversation flashes are added on top of them, with saturating math, the
+// same way that the light of the separate RGB and W LEDs adds up on a CRGBW
+// strip. The blend, the gamma table and the conversion to gray are all done
+// in a single pass over the slit.
+template <> struct CE3KpixelOps<CRGB>
+{
+  static inline void blendRows(const uint8_t* thisRow, const uint8_t* nextRow, uint8_t blendWeight, CRGB* slit, uint16_t count)
+  {
+    uint16_t thisWeight = 256 - blendWeight;
+    while (count--)
     {
-      index2 += (int)difference;
-      while (index2 >= secondArraySize) index2 -= secondArraySize;
-      while (index2 < 0)               index2 += secondArraySize;
+      uint8_t white = scannerGammaTable[(((uint16_t)*(nextRow++) * blendWeight) >> 8) + (((uint16_t)*(thisRow++) * thisWeight) >> 8)];
+      slit->red   = white;
+      slit->green = white;
+      slit->blue  = white;
+      slit++;
     }
   }
 
-  // Save the master position for the next function call.
-  lastPosition = arrayPosition;
+  static inline void    setWhite(CRGB& pixel, uint8_t white) { pixel.red = white; pixel.green = white; pixel.blue = white; }
+  static inline uint8_t getWhite(const CRGB& pixel)          { return pixel.red; }
 
-  // If only one array is used, then the second array will be empty and will
-  // have a size of zero. Detect this and use only the first array.
-  bool blackOrWhitePixel;
-  if (secondArraySize > 0)
+  static inline void paint(CRGB& pixel, const CRGB& slit, const CRGB& color)
   {
-    // This is where the code ANDs the two arrays together so that any black
-    // stripes are preserved, simulating the original fiber optic effect, where
-    // the photosensor controlling the fiber optic light is blocked by black.
-    blackOrWhitePixel = pgm_read_byte(&firstArray[index1]) & pgm_read_byte(&secondArray[index2]);
+    pixel.red   = qadd8(slit.red,   color.red);
+    pixel.green = qadd8(slit.green, color.green);
+    pixel.blue  = qadd8(slit.blue,  color.blue);
   }
-  else
+
+  static inline uint32_t power(const CRGB& pixel)
   {
-    // If only one array is being used, then just return that byte in the array.
-    blackOrWhitePixel = pgm_read_byte(&firstArray[index1]);
+    return ((uint32_t)pixel.red  * CE3K_POWER_RED_MW) + ((uint32_t)pixel.green * CE3K_POWER_GREEN_MW) +
+           ((uint32_t)pixel.blue * CE3K_POWER_BLUE_MW);
   }
 
-  // Work in progress: I'm working on GitHub issue #8 - trying to allow for
-  // larger patterns with proper antialiasing. At the moment this is still
-  // converting  the binary 0 or 1 value into a pixel darkness value, i.e., 0
-  // becomes 0, 1 becomes full brightness. I will be working on making shades
-  // of gray possible later.
-  // 
-  // Note: I originally had this line:
-  //      return blackOrWhitePixel * SCANNER_BRIGHTNESS;
-  //
-  // Which was intended to work if True was 1 and False was 0. But I was finding
-  // that True was not casting to 1, it was casting to a larger number. Instead
-  // do a test on blackOrWhitePixel and then multiply either the 1 or the 0
-  // times the scanner brightness value. This is going to be rewritten when the
-  // arrays become shades of gray.
-  return (blackOrWhitePixel ? 1 : 0) * SCANNER_BRIGHTNESS;
-}
+  static inline void fillSpan(CRGB* pixels, const CRGB* slit, uint16_t column, uint16_t width, uint16_t count, const CRGB& color)
+  {
+    while (count--)
+    {
+      paint(*(pixels++), slit[column], color);
+      if (++column >= width) { column = 0; }
+    }
+  }
+
+  static inline void eraseSpan(CRGB* pixels, const CRGB* slit, uint16_t column, uint16_t width, uint16_t count)
+  {
+    // Copied a whole run of the slit at a time, up to where it wraps around.
+    while (count > 0)
+    {
+      uint16_t run = width - column;
+      if (run > count) { run = count; }
+      memmove8(pixels, &slit[column], run * sizeof(CRGB));
+      pixels += run;
+      count  -= run;
+      column  = 0;
+    }
+  }
+};
+
+typedef CE3KpixelOps<CE3KledPixel> CE3KledOps;
+
+#if CE3K_ZERO_COPY_OUTPUT
+// Description of one frame of the whole strand, for zero-copy output (see
+// CE3K_ZERO_COPY_OUTPUT). Each patch paints a single conversation flash color
+// on top of a run of pixels of the slit, see CE3KpixelOps::paint(). The
+// patches are kept in order along the strand and never overlap.
+#define CE3K_MAX_PATCHES (6 * CONVERSATION_MAX_FLASHES)  // Enough for every piece of the overlapping conversation flashes.
+
+typedef struct
+{
+  uint16_t Start;           // First pixel of the patch on the strand.
+  uint16_t Count;           // Number of pixels in the patch.
+  CRGB     Color;           // RGB value of every pixel in the patch.
+} CE3Kpatch;
 
+typedef struct
+{
+  const CE3KledPixel* Slit;        // Slit view of the current frame.
+  uint16_t            Width;       // Number of pixels in the slit view.
+  uint16_t            Repeats;     // Number of full copies of the slit along the strand.
+  uint16_t            Remainder;   // Number of pixels of the slit in the last, partial copy.
+  uint8_t             NumPatches;
+  CE3Kpatch           Patches[CE3K_MAX_PATCHES];
+} CE3KstrandFrame;
+
+#endif
+
+// Number of milliseconds between pattern changes.
+#ifndef CE3K_PATTERN_CHANGE_INTERVAL
+#define CE3K_PATTERN_CHANGE_INTERVAL 15000
+#endif
+
+static_assert(CE3K_PATTERN_CROSSFADE < CE3K_PATTERN_CHANGE_INTERVAL, "CE3K Scanner: CE3K_PATTERN_CROSSFADE must be shorter than CE3K_PATTERN_CHANGE_INTERVAL.");
+
+// Synchronized scanners on several controllers. Each scanner keeps a "shared
+// time", the number of milliseconds since its pattern rotation started, and
+// its whole state is a function of that time, so CE3Kscanner::seek() can jump
+// straight to any time without playing the frames in between. To keep
+// several controllers in lockstep, one of them sends out sync messages with
+// its shared time (see ce3kWriteSyncMessage), and the others pass the times
+// they receive to syncTo(), which seeks whenever their own time is more than
+// CE3K_SYNC_TOLERANCE milliseconds away from it.
+//
+// The scanner bars and the pattern changes can always be sought exactly. The
+// conversation flashes, though, normally depend on every flash that came
+// before them. With CE3K_CONVERSATION_EPOCH left at 0, the default, the
+// conversation is the original, unbroken one, and seek() starts it over with
+// no flashes running, and with a random seed worked out from the time it
+// seeks to. So controllers which seek to the same time play the same flashes
+// from then on, but a controller which has to seek again later, after a
+// stall, plays different flashes from the others until they seek again too.
+// For installations of several controllers, set CE3K_CONVERSATION_EPOCH to a
+// number of milliseconds (3900 works well) in the sketch of each of them.
+// The conversation then starts over at the beginning of each epoch of that
+// length, with no flashes running, and with a random seed worked out from
+// the scanner's seed and the number of the epoch, so that a seek lands on
+// exactly the same flashes as every other controller. New flashes aren't
+// started near the end of an epoch, so that the last of them can finish,
+// which makes a short pause in the conversation. Seeking only has to play
+// the conversation from the start of the current epoch, so keep the epoch to
+// a few seconds.
+#ifndef CE3K_CONVERSATION_EPOCH
+#define CE3K_CONVERSATION_EPOCH  0
+#endif
+#ifndef CE3K_SYNC_TOLERANCE
+#define CE3K_SYNC_TOLERANCE      2
+#endif
+
+// Longest that a conversation flash can be running, in color flash animation
+// frames: swelling up, dwelling, unswelling, and one more frame for the soft
+// edges. See stepConversation() for the animation.
+#define CE3K_FLASH_MAX_STEPS (((CONVERSATION_FLASH_MIN_FRAMES + CONVERSATION_FLASH_MAX_FRAMES) / (2 * CONVERSATION_FLASH_FRAMESKIP) + 1) + \
+                              (CONVERSATION_EXTRA_DWELL_MAX / CONVERSATION_FLASH_FRAMESKIP + 1) +                                      \
+                              ((CONVERSATION_FLASH_MIN_FRAMES + CONVERSATION_FLASH_MAX_FRAMES) / CONVERSATION_FLASH_FRAMESKIP + 3) + 1)
+
+#if CE3K_CONVERSATION_EPOCH > 0
+#define CE3K_CONVERSATION_EPOCH_STEPS (CE3K_CONVERSATION_EPOCH / CONVERSATION_FLASH_SPEED)
+static_assert(CE3K_CONVERSATION_EPOCH_STEPS >= 4 * CE3K_FLASH_MAX_STEPS, "CE3K Scanner: CE3K_CONVERSATION_EPOCH is too short to leave time for any color flashes.");
+#endif
 
 // ---------------------------------------------------------------------------
-// Subroutine to add the colored flashing "conversation" lights, atop the moving
-// white "idle" animation bars. The original colored lights in the film were
-// hand-animated by Robert Swarthe, this attempts to simulate their style.
+// Define a data structure called "CE3Kflash", which holds the state of one of
+// the color conversation flashes. The flashes live in a fixed-size pool, so
+// that several of them can be animating at the same time, as they sometimes
+// are in the film. See stepConversation() for details of the animation.
 // ---------------------------------------------------------------------------
-void CE3Kconversation()
+typedef struct
 {
-  // Each color flash has to go through several frames of animation for the
-  // entire flash. Keep track of both things with the variable "flashStage":
-  // flashStage 0 means no flash is occurring, flashStage nonzero means that we
-  // are in the middle of a color flash animation. Each time a frame of the
-  // animation is played, it increments or decrements the flashStage variable
-  // (incrementing when the color bar is swelling up to its full length,
-  // decrementing when it's unswelling down to nothing). A separate variable,
-  // flashFrames, keeps track of the number of swelling frames in this
-  // animation (each flash will have a different size and thus a different
-  // number of frames). Then if flashStage reaches flashFrames, that means it's
-  // the last frame of the swell-up animation and it then dwells for a bit,
-  // then switches direction and decrements down to zero. Once it hits zero,
-  // then the animation is done and it waits until the next color flash is
-  // triggered.
-  //
-  // TO DO: In the film, there are some moments in the scene where multiple
-  // color flashes occur at the same time. This code only does one flash at a
-  // time. Investigate refactoring the code to keep track of multiple flashes.
-  static int  flashStage      = 0;
-  static int  flashFrames     = 0;
-  static int  flashDwell      = 0;
-  static bool flashIncreasing = false;
-
-  // Initialize the variables which will be used to control the width, position,
-  // and color of the color flash bar. These remain the same across multiple
-  // loops, so they are declared as static, and they only get changed when a
-  // new flash is triggered.
-  static int  colorBarWidth      = 0;
-  static int  colorBarTempWidth  = 0;
-  static int  halfWayMark        = 0;
-  static int  colorBarStartPoint = 0;
-  static int  colorBarHue        = 0;
-  static CRGB colorBarColor      = (0,0,0);
-  uint8_t     onePixelBrightness = 0;
-
-  // Each frame of the color flash animation happens at this speed.
-  EVERY_N_MILLISECONDS ( CONVERSATION_FLASH_SPEED )
-  {
-    // If we're currently not in the middle of a flash animation, decide
-    // whether this frame will begin a new flash animation.
-    if (flashStage < 1)
-    {
-      // Flash animation decision is random, governed by this threshold.
-      // Generate a random number between 0 and 1000, and if the number is
-      // larger than the threshold, trigger a new color flash animation.
-      if (random16(1000) > CONVERSATION_FLASH_FREQUENCY)
-      {
-        // Begin the color flash animation.
-        flashStage         = 1;   
-        flashIncreasing    = true;
+  int  Stage;       // 0 means this flash is idle, nonzero means it is in the middle of its animation.
+  int  Frames;      // Number of swelling frames in this flash's animation.
+  int  Dwell;       // Remaining frames to dwell at full extension.
+  bool Increasing;  // True while the bar is swelling, false while it is unswelling.
+  int  StartPoint;  // First pixel of the color bar on the LED strand.
+  int  Width;       // Full width of the color bar.
+  int  HalfWayMark; // Center of the color bar, counted from StartPoint.
+  int  TempWidth;   // Distance from the center that the lit pixels extend on this frame.
+  int  PrevStage;   // Stage before the most recent animation frame, for CONVERSATION_SOFT_EDGES.
+  int  Hue;         // Random hue of this flash.
+  CRGB Color;       // The hue, converted to RGB.
+} CE3Kflash;
+
+// One piece of the composited conversation overlay: a run of pixels on the
+// strand which are either all lit with the same color, or all dark.
+typedef struct
+{
+  int  Start;       // First pixel of the run.
+  int  End;         // One past the last pixel of the run.
+  bool Lit;
+  CRGB Color;
+} CE3KflashSpan;
 
-        // Randomize the size and position of the color bar flash. 
-        colorBarWidth      = random16(CONVERSATION_FLASH_MAX_FRAMES) + CONVERSATION_FLASH_MIN_FRAMES;
-        flashDwell         = random16(CONVERSATION_EXTRA_DWELL_MAX); // Color bar can dwell at its widest point for a certain number of frames.
-        colorBarStartPoint = random16(CONVERSATION_START_POINT_MAX - CONVERSATION_START_POINT_MIN - colorBarWidth) + CONVERSATION_START_POINT_MIN; 
-        colorBarHue        = random8();                              // Random hue for each color light flash.
+// Up to six edges per flash (both ends of its bar, both ends of the lit part
+// of its bar, and the far sides of its soft end pixels) cut the strand into
+// at most this many pieces.
+#define CE3K_MAX_FLASH_SPANS (6 * CONVERSATION_MAX_FLASHES)
 
-        // Ensure we do not overwrite memory by making sure the start/end points
-        // don't exceed the start or end of the LED strand. This should only be
-        // needed when running on a small test strip where the width of the
-        // color bars could become greater than the length of the strand.
-        if (colorBarStartPoint < 0) { colorBarStartPoint = 0; }
-        if (colorBarStartPoint >= NUM_LEDS) { colorBarStartPoint = random16(NUM_LEDS - colorBarWidth); }
-        if (colorBarStartPoint + colorBarWidth >= NUM_LEDS) { colorBarWidth = NUM_LEDS - colorBarStartPoint - 1; }
+// ---------------------------------------------------------------------------
+// Scanner instances
+// ---------------------------------------------------------------------------
+// Everything that the scanner keeps from one frame to the next lives in a
+// CE3Kscanner, so that one controller can run several independent scanners,
+// each on its own stretch of the LED strand, with its own pattern, its own
+// scroll position and its own conversation flashes. For example, a sketch
+// with three rings on one strand can declare "CE3Kscanner rings[3]", give
+// each of them its own part of leds[] in setup(), and then call
+// ce3kUpdateScanners(rings, 3) from loop().
+//
+// The pixel arrays, the pattern table and the gamma table are shared by all
+// of the scanners, since nothing writes to them while the scanners are
+// running. So each extra scanner only costs the RAM of its own state below,
+// and since none of the scanner code keeps any state outside of a CE3Kscanner
+// (not even the random numbers of the conversation flashes), scanners can
+// also be run at the same time on different processor cores. The one
+// exception is the optional profiler (see CE3K_PROFILE), whose statistics are
+// shared by all of the scanners, so it can only be used with scanners which
+// all run on the same core.
+//
+// The sketch in this folder runs a single scanner, ce3kMainScanner, over the
+// whole of leds[], through ce3kSetup() and ce3kScanner() at the bottom of
+// this file.
+// ---------------------------------------------------------------------------
+struct CE3Kscanner
+{
+  // The stretch of the LED strand which this scanner draws on. Everything
+  // below which counts pixels along the strand, such as the dirty range and
+  // the start points of the conversation flashes, counts from the start of
+  // this stretch.
+  CE3KledPixel* leds;
+  uint16_t      numLeds;
+
+  // State of the scanner animation, which is kept from one frame to the next.
+  CE3Kpattern currentPattern;           // RAM copy of the pattern which is currently running.
+  int         currentPatternIndex;      // Which index in the table of patterns is the current pattern.
+  uint32_t    scrollPosition;           // Which line of the zigzag arrays are we on, in 16.16 fixed point?
+  uint32_t    lastFrameTime;            // Value of millis() at the previous frame.
+  uint32_t    epochMillis;              // Value of millis() at shared time 0 (see seek).
+  int         firstPatternIndex;        // Pattern which runs first, from shared time 0.
+
+  // Scroll speed of the current pattern, in rows per millisecond, as a 16.16
+  // fixed-point number (see CE3K_ROWS_PER_SECOND). This is set from the
+  // pattern's Speed each time a pattern is activated. It can also be changed
+  // at any time in between, for example to ramp the speed up or down smoothly,
+  // since the scroll position itself never jumps when the speed changes.
+  uint32_t    scrollSpeed;
+
+  // Values I'm using for some speed optimizations to avoid expensive
+  // division operations during the main loop.
+  uint16_t slitWidth;                   // Number of pixels in the slit view which gets copied onto the LED strip (see setSlitWidth).
+  uint16_t slitCopyFullRepeatsCount;    // How many full, un-truncated slit pattern strips fit inside the total LED strip.
+  uint16_t slitCopyRemainingLeds;       // Number of leftover pixels need to be copied for the last remainder to fill the LED strip.
+  uint16_t scrollPeriodRows;            // Rows before the current pattern repeats exactly, or 0 if unknown (see activatePattern).
+
+  // State of the frame scheduler, see update().
+  uint32_t    nextFrameTime;            // Value of millis() when the next frame is due.
+  uint32_t    patternElapsed;           // Milliseconds the current pattern has been running.
+  uint16_t    conversationElapsed;      // Milliseconds not yet played by the conversation animation.
+  uint8_t     lateFrames;               // Recent late frames, forgotten after CE3K_OVERLOAD_FRAMES on-time frames in a row.
+  uint8_t     onTimeFrames;             // On-time frames in a row since the last late frame.
+
+  // This is an array of values that represents the "slit" view of the zigzag
+  // patterns, in the same pixel type as the LED strand, so that it can be
+  // copied straight onto the strand.
+  CE3KledPixel zigzagSlit[SLIT_ARRAY_WIDTH];
+
+  // Darkness values of the current row and the following row of the pattern,
+  // which get blended together into the slit array for subpixel antialiasing.
+  // These are in perceptual brightness units, from 0 to 255, before the
+  // SCANNER_GAMMA curve is applied.
+  uint8_t slitThisRow[WIDEST_ARRAY];
+  uint8_t slitNextRow[WIDEST_ARRAY];
+
+  // Copy of the slit view which is currently on the strand, so that a frame
+  // whose slit view hasn't changed can skip the copy onto the strand.
+  CE3KledPixel shownSlit[SLIT_ARRAY_WIDTH];
+  uint16_t     shownSlitWidth;
+
+  // Dirty-range tracking. Whenever update() changes any pixel of the strand,
+  // it sets frameChanged, and widens the range from dirtyMin to dirtyMax
+  // (inclusive) to cover the changed pixels. Most calls to update() happen
+  // in between the frames of the animations, and change nothing at all, so
+  // the sketch can skip FastLED.show() unless the frame has changed. Once
+  // the strand has been sent, call clearDirty(). Drivers which can update
+  // part of a strand need only send the dirty range.
+  bool     frameChanged;
+  uint16_t dirtyMin;
+  uint16_t dirtyMax;
+
+  // The pool of conversation flashes, and the lit spans that are currently
+  // painted onto the strand (or, with zero-copy output, recorded as patches).
+  // Comparing against the painted spans lets the conversation skip frames
+  // where the color bars haven't changed, and tells it which pixels to erase
+  // when they have.
+  CE3Kflash     flashes[CONVERSATION_MAX_FLASHES];
+  CE3KflashSpan paintedSpans[CE3K_MAX_FLASH_SPANS];
+  uint8_t       numPaintedSpans;
+
+  // Seed of this scanner's own random number generator, which decides when
+  // and where the conversation flashes appear (see nextRandom16).
+  uint16_t randomSeed;
+
+  // Seed given to setup(), from which the seed of each conversation epoch,
+  // or of the conversation after a seek, is worked out (see seek).
+  uint16_t conversationSeed;
+
+#if CE3K_CONVERSATION_EPOCH > 0
+  // Conversation epochs (see CE3K_CONVERSATION_EPOCH). The step count is the
+  // number of color flash animation frames played since shared time 0.
+  uint32_t conversationStep;
+#endif
+
+#if CE3K_ZERO_COPY_OUTPUT
+  // Description of the current frame of the strand, for zero-copy output.
+  CE3KstrandFrame strandFrame;
+#endif
+
+#if CE3K_POWER_ESTIMATE
+  // Power estimate of the strand (see CE3K_POWER_ESTIMATE), at full
+  // brightness, in 1/256ths of a milliwatt. It is kept in two parts: the
+  // scanner bars, which are copies of the slit, and the extra drawn by the
+  // conversation flashes on top of them. Each part is only worked out again
+  // when it changes.
+  uint32_t slitPower;
+  uint32_t flashPower;
+#endif
+
+#if CE3K_PATTERN_CROSSFADE > 0
+  // State of the outgoing pattern during a crossfade (see CE3K_PATTERN_CROSSFADE).
+  bool        crossfading;              // True while a crossfade is in progress.
+  uint16_t    crossfadeElapsed;         // Milliseconds of the crossfade which have run so far.
+  CE3Kpattern fadingPattern;            // RAM copy of the outgoing pattern.
+  uint32_t    fadingScrollPosition;     // Scroll position of the outgoing pattern, in 16.16 fixed point.
+  uint32_t    fadingScrollSpeed;        // Scroll speed of the outgoing pattern, in 16.16 rows per millisecond.
+  uint16_t    fadingPeriodRows;         // Rows before the outgoing pattern repeats exactly, or 0 if unknown.
+
+  // White values of the outgoing and incoming slit views, at their own widths,
+  // which get blended together into the slit array.
+  uint8_t crossfadeFromSlit[WIDEST_ARRAY];
+  uint8_t crossfadeToSlit[WIDEST_ARRAY];
+#endif
+
+#if CE3K_FRAME_CACHE_BYTES > 0
+  // Frame cache (see CE3K_FRAME_CACHE_BYTES). The cache holds the final white
+  // values of each slit view, frame after frame, for the current pattern,
+  // with one bit per frame to say whether that frame has been filled in yet.
+  uint8_t  frameCache[CE3K_FRAME_CACHE_BYTES];
+  uint8_t  frameCacheFilled[(CE3K_FRAME_CACHE_MAX_FRAMES + 7) / 8];
+  uint32_t frameCachePeriod;            // Number of blend steps in one full cycle of the current pattern (0 if it can't be cached).
+  uint32_t frameCacheFrames;            // Number of frames from the start of the cycle which fit in the cache.
+  uint32_t frameCacheHits;              // Frames served from the cache since the pattern was activated.
+  uint32_t frameCacheMisses;            // Frames rendered live since the pattern was activated.
+#if CE3K_FRAME_CACHE_REPORT
+  // Statistics of the outgoing pattern, which ce3kFrameCacheReport() prints
+  // after each pattern change.
+  bool     frameCacheReportDue;
+  int      reportPatternIndex;
+  uint32_t reportPeriod;
+  uint32_t reportFrames;
+  uint32_t reportHits;
+  uint32_t reportMisses;
+#endif
+#endif
+
+  // The functions which run the scanner. See each of them below for details.
+  void     setup(CE3KledPixel* strand, uint16_t count, int patternIndex = 0, uint16_t seed = 1337);
+  void     update(uint32_t now);
+  void     activatePattern(int patternIndex);
+  void     clearDirty();
+  uint32_t sharedTime(uint32_t now);
+  void     seek(uint32_t time, uint32_t now);
+  bool     syncTo(uint32_t time, uint32_t now);
+#if CE3K_POWER_ESTIMATE
+  uint32_t powerMilliwatts();
+  uint8_t  powerBrightness(uint8_t targetBrightness, uint32_t maxMilliwatts);
+#endif
+#if CE3K_ZERO_COPY_OUTPUT
+  void     expandStrand(CE3KledPixel* destination);
+#endif
+#if CE3K_FRAME_CACHE_BYTES > 0 && CE3K_FRAME_CACHE_REPORT
+  void     reportFrameCache();
+#endif
+
+  // Helpers used by the functions above.
+  inline void markDirty(uint16_t first, uint16_t last);
+  inline bool overloaded();
+  uint16_t nextRandom16(uint16_t limit);
+  uint8_t  nextRandom8();
+  void     setSlitWidth(uint16_t width);
+  uint32_t scrollPositionAt(uint32_t elapsed);
+  void     fetchSlitRowsBytes(const CE3Kpattern& pattern, long imageOffset);
+  void     fetchSlitRowsPacked(const CE3Kpattern& pattern, long imageOffset);
+  void     fetchSlitRowsRle(const CE3Kpattern& pattern, long imageOffset);
+  void     fetchSlitRowsGray(const CE3Kpattern& pattern, long imageOffset);
+  void     assembleSlitRow(const CE3Kpattern& pattern, long imageOffset, uint8_t blendWeight);
+  uint8_t  compositeFlashSpans(CE3KflashSpan* spans);
+  void     stepConversation();
+  void     paintConversation();
+  void     eraseConversation();
+#if CE3K_POWER_ESTIMATE
+  void     updateSlitPower(const CE3KledPixel* slit, uint16_t width, uint16_t repeats, uint16_t remainder);
+#endif
+#if CE3K_PATTERN_CROSSFADE > 0
+  void     crossfadeToPattern(int patternIndex);
+  void     advanceCrossfade(uint32_t elapsed);
+  void     crossfadeSlit();
+#endif
+#if CE3K_FRAME_CACHE_BYTES > 0
+  void     resetFrameCache();
+  bool     readFrameCache(const CE3Kpattern& pattern, uint32_t scrollPosition);
+#endif
+};
 
-        // Half way mark that defines the center of the color flash.
-        //   halfWayMark = colorBarWidth / 2;
-        // Speed optimization: Do a right bitwise shift by one position, which is
-        // a faster way to do a divide-by-2 with integer math on this chipset.
-        halfWayMark = colorBarWidth >> 1; 
+// ---------------------------------------------------------------------------
+// Dirty-range tracking, see CE3Kscanner::frameChanged.
+// ---------------------------------------------------------------------------
+inline void CE3Kscanner::markDirty(uint16_t first, uint16_t last)
+{
+  frameChanged = true;
+  if (first < dirtyMin) { dirtyMin = first; }
+  if (last  > dirtyMax) { dirtyMax = last; }
+}
 
-        // Number of animation frames is the same as the color bar width.
-        flashFrames = colorBarWidth;
- 
-        // Create an HSV value based on the random hue, then convert HSV to RGB so
-        // that I can paint *just* the RGB values into the RGBW strip but *not*
-        // the W, which is responsible for the idle scanner effect.
-        CHSV colorBarhsv(colorBarHue, 255, CONVERSATION_BRIGHTNESS);
-        hsv2rgb_rainbow( colorBarhsv, colorBarColor);  
-      }
-    }
+void CE3Kscanner::clearDirty()
+{
+  frameChanged = false;
+  dirtyMin     = 0xFFFF;
+  dirtyMax     = 0;
+}
 
-    // Increment or decrement the animation frame, depending on the current
-    // stage of the flash animation we're in right now. This must be done
-    // within the "EVERY_N_MILLISECONDS" section so that the timing of the
-    // animation is preserved.
-    if (flashStage > 0)
-    {
-      // Increment or decrement the color flash animation frame we're in, which
-      // will control whether the color bar is swelling or unswelling.
-      if (flashIncreasing)
-      {
-        // The color bar swells to full width twice as quickly as it unswells.
-        // Since each color flash represents a musical note, this is like
-        // giving the note a sharper attack than the note's decay. This seems
-        // to look best. I asked Robert Swarthe if that's the way he did it,
-        // and he doesn't remember, but said that it sounds like something he'd
-        // probably do.
-        flashStage += CONVERSATION_FLASH_FRAMESKIP;
-        flashStage += CONVERSATION_FLASH_FRAMESKIP;
-      }
-      else
-      {
-        flashStage -= CONVERSATION_FLASH_FRAMESKIP;
-      }
+// ---------------------------------------------------------------------------
+// Whether the frame scheduler is running at reduced quality, because frames
+// have been late for a while rather than just once. See CE3K_OVERLOAD_FRAMES.
+// ---------------------------------------------------------------------------
+inline bool CE3Kscanner::overloaded()
+{
+  return (CE3K_OVERLOAD_FRAMES > 0) && (lateFrames >= CE3K_OVERLOAD_LATE_FRAMES);
+}
 
-      // The distance from the center of the color flash that the pixels extend.
-      // This controls the swell size of the color bar. Basically the color bar
-      // is divided down the center, and it swells from that center point
-      // leftward towards the 0 mark of the color bar, and from the center
-      // point rightward toward the max mark of the color bar. This value
-      // controls how far from the center point it swells on this frame of the
-      // animation.
-      //   colorBarTempWidth = flashStage / 2;
-      // Speed optimization: Do a right bitwise shift by one position, which is
-      // a faster way to do a divide-by-2 with integer math on this chipset.
-      colorBarTempWidth = flashStage >> 1; 
- 
-      // If we have reached widest point of the color flash animation, either
-      // dwell at the widest point for a bit (like the sustain portion of a
-      // musical note), or switch direction so that it decreases the bar's
-      // width (like the decay portion of a musical note).
-      if (flashStage > flashFrames)
-      {
-        if (flashDwell > 0)
-        {
-          // During the dwell period, flashStage will keep getting
-          // double-incremented in an earlier step. By decrementing it here
-          // during the dwell, we keep it bumping up against the "wall" of the
-          // fully-extended bar width.
-          flashStage -= CONVERSATION_FLASH_FRAMESKIP; 
-          flashStage -= CONVERSATION_FLASH_FRAMESKIP; 
-          flashDwell -= CONVERSATION_FLASH_FRAMESKIP; // Count down the dwell towards zero.
-        }
-        else
-        {
-          // If there's no dwell, or if we're done with the dwell, then start
-          // decreasing the bar width instead of increasing it.
-          flashIncreasing = false;  
-        }
-      }
-    }
-  }
+// ---------------------------------------------------------------------------
+// Random numbers for the conversation flashes. This is the same generator,
+// with the same math, as FastLED's random16() and random8(), but each
+// scanner has its own seed, so that scanners running side by side, or on
+// different processor cores, don't disturb each other's flashes. A scanner
+// started from FastLED's own starting seed (1337) plays exactly the same
+// flashes as the scanner used to when it called FastLED's functions.
+// ---------------------------------------------------------------------------
+uint16_t CE3Kscanner::nextRandom16(uint16_t limit)
+{
+  randomSeed = (randomSeed * 2053) + 13849;
+  return ((uint32_t)limit * randomSeed) >> 16;
+}
 
-  // Paint the current color flash bar onto the LED strand. Note: Must do this
-  // outside the "EVERY_N_MILLISECONDS" section so that the color flash pixels
-  // are applied to the strand on every loop. This prevents the color bars from
-  // rapidly flickering each loop.
-  if (flashStage > 0)
-  {
-    // Cycle through all pixels of the color bar from left to right.
-    for (int c = colorBarStartPoint; c <= colorBarStartPoint + colorBarWidth; c++)
-    {
-      // Determine if each color bar pixel should be lit or dark, based on our
-      // position through the loop. Note that some of these "if" statements
-      // make a color decision about one of the pixels, and then a later
-      // statement makes a different decision about the same pixel. By design.
-      if (c > colorBarStartPoint + halfWayMark - colorBarTempWidth)   
-      {
-        // Left half of the color bar, lit pixels.
-        onePixelBrightness = 255;
-      }
-      else
-      {
-        // Left half of the color bar, dark pixels. 
-        onePixelBrightness = 0;
-      }
-      if (c > colorBarStartPoint + halfWayMark  )
-      {
-        // Right half of the color bar, lit pixels.
-        onePixelBrightness = 255;
-      }
-      if (c > colorBarStartPoint + halfWayMark + colorBarTempWidth  ) 
-      {
-        // Right half of the color bar, dark pixels. 
-        onePixelBrightness = 0;
-      }  
+uint8_t CE3Kscanner::nextRandom8()
+{
+  randomSeed = (randomSeed * 2053) + 13849;
+  return (uint8_t)(randomSeed & 0xFF) + (uint8_t)(randomSeed >> 8);
+}
 
-      // Apply the color flash to the LED strand. Modify only the RGB values and
-      // do not touch the W value in the CRGBW strand. The W value is already
-      // being used for scrolling the black and white "idle scanner" animation
-      // running in parallel to these color flashes.
-      //
-      // If you're using CRGB LEDs instead of CRGBW LEDs, and refactoring this
-      // code to use them, then here is where you'll have to blend the
-      // conversation colors with the white idle scanner pixels that are
-      // already there.
-      leds[c].red = colorBarColor.red * onePixelBrightness; 
-      leds[c].green = colorBarColor.green * onePixelBrightness;
-      leds[c].blue = colorBarColor.blue * onePixelBrightness;
-    }
-  }
+// Random seed for one conversation epoch, mixed from the scanner's seed and
+// the number of the epoch, so that neighboring epochs look nothing alike.
+// Without epochs, seek() uses the number of the color flash animation frame
+// it seeks to instead.
+uint16_t ce3kEpochSeed(uint16_t seed, uint32_t epoch)
+{
+  uint32_t x = ((uint32_t)seed << 16) ^ epoch;
+  x ^= x >> 16;
+  x *= 0x7FEB352D;
+  x ^= x >> 15;
+  x *= 0x846CA68B;
+  x ^= x >> 16;
+  return (uint16_t)x;
 }
 
+#if CE3K_POWER_ESTIMATE
 // ---------------------------------------------------------------------------
-// Create/update a lookup table of the current pattern subpixel resolution and
-// other variables, so that every time through the animation loop, it doesn't
-// run a costly floating point division operation to get the antialiasing
-// blend-weights and other values. Only do these costly division operations
-// once, each time a new pattern is activated. Note: Hard coding the first
-// entry in the table(index[0]) as a 0, instead of trying to calculate that
-// first entry, in order to prevent divide by zero errors in this function.
+// Work out the power of the slit view, copied along the strand "repeats"
+// times, plus the first "remainder" pixels of it once more at the end.
 // ---------------------------------------------------------------------------
-void updateDivTable(int currentPatternIndex)
+void CE3Kscanner::updateSlitPower(const CE3KledPixel* slit, uint16_t width, uint16_t repeats, uint16_t remainder)
 {
-  int subpixelResolution = CE3Kpatterns[currentPatternIndex].SubpixelResolution;
-  div256Table[0] = 0; 
-  for (uint8_t tableIndex = 1; tableIndex < subpixelResolution; tableIndex++)
+  uint32_t sum = 0;
+  uint32_t partialSum = 0;
+  for (uint16_t x = 0; x < width; x++)
   {
-    div256Table[tableIndex] = ((float)1 / subpixelResolution) * tableIndex * 256;
+    if (x == remainder) { partialSum = sum; }
+    sum += CE3KledOps::power(slit[x]);
   }
+  slitPower = (sum * repeats) + partialSum;
+}
 
-  // Precalculate additional division variables. These variables control the
-  // operation which copies each "slit" view of the patterns onto the full size
-  // of the entire LED strip. 
-  uint16_t patternWidth =  CE3Kpatterns[currentPatternIndex].Width;
-  slitCopyFullRepeatsCount = NUM_LEDS / patternWidth;   // How many full, un-truncated blocks fit inside the strip.
-  slitCopyRemainingLeds = NUM_LEDS % patternWidth;      // Number of leftover pixels need to be copied for the last remainder.
+// ---------------------------------------------------------------------------
+// Power drawn by this scanner's stretch of the strand at full brightness, in
+// milliwatts.
+// ---------------------------------------------------------------------------
+uint32_t CE3Kscanner::powerMilliwatts()
+{
+  return ((slitPower + flashPower) >> 8) + ((uint32_t)numLeds * CE3K_POWER_DARK_MW);
 }
 
 // ---------------------------------------------------------------------------
-// Main loop of the CE3K scanner effect. This routine should be called once
-// per "loop()" of the main Arduino code. This routine is responsible for
-// generating the moving white "idle" bars of the scanner ring animation.
+// Brightness to show the current frame at, so that it draws no more than
+// maxMilliwatts, or the target brightness if that is already low enough.
+// This is the same calculation as FastLED's power limiter, so it can be
+// passed straight to FastLED.setBrightness() just before FastLED.show().
 // ---------------------------------------------------------------------------
-void ce3kScanner()
+uint8_t CE3Kscanner::powerBrightness(uint8_t targetBrightness, uint32_t maxMilliwatts)
 {
-  static long imageOffset = 0;        // Which line of the zigzag arrays are we on?
-  static int subPixelOffset = 0;      // Move through the arrays slowly while antialiasing.
-  static CE3Kpattern currentPattern;  // Which pattern is currently running.
-  static int currentPatternIndex;     // Which index in the array of pattern data structures is the curernt pattern.
-  static bool firstTime = true;       // Keep track of code which only needs to be run the first time through the loop.
-  
-  // Only animate the scanner lights at a certain frame rate.
-  EVERY_N_MILLISECONDS ( SCANNER_ANIMATION_SPEED )
-  {
-    // Perform actions on the first run of this function only.
-    if (firstTime)
-    {
-      firstTime = false;
-
-      // Initialize the slit view array to black.
-      fill_solid( zigzagSlit, WIDEST_ARRAY, CRGBW(0,0,0,0) );
-
-      // Initialize the data in all of the pattern data structures. Make sure to
-      // update the variable definition NUM_CE3K_PATTERNS at the top of the code
-      // too. Since this is something that I might tend to forget myself, I'm
-      // using a "trick" here with the checkPatternIndex variable, to force
-      // myself to ensure that NUM_CE3K_PATTERNS equals the number of definitions
-      // here.
-      int checkPatternIndex = -1;
-
-      checkPatternIndex++;
-      CE3Kpatterns[checkPatternIndex].ArrayA = arrayTony01;
-      CE3Kpatterns[checkPatternIndex].ArrayB = arrayTony02;
-      CE3Kpatterns[checkPatternIndex].SizeA  = arrayTony01Size;  
-      CE3Kpatterns[checkPatternIndex].SizeB  = arrayTony02Size;
-      CE3Kpatterns[checkPatternIndex].Width  = arrayTony01Width;
-      CE3Kpatterns[checkPatternIndex].SubpixelResolution = 5;
-
-      checkPatternIndex++;
-      CE3Kpatterns[checkPatternIndex].ArrayA = arrayTony03;
-      CE3Kpatterns[checkPatternIndex].ArrayB = arrayTony04;
-      CE3Kpatterns[checkPatternIndex].SizeA  = arrayTony03Size;  
-      CE3Kpatterns[checkPatternIndex].SizeB  = arrayTony04Size;
-      CE3Kpatterns[checkPatternIndex].Width  = arrayTony03Width;
-      CE3Kpatterns[checkPatternIndex].SubpixelResolution = 15;   // Do not go above MAX_SUBPIXELS
-
-      checkPatternIndex++;
-      CE3Kpatterns[checkPatternIndex].ArrayA = arrayConversationPairs;
-      CE3Kpatterns[checkPatternIndex].ArrayB = arrayBlank;
-      CE3Kpatterns[checkPatternIndex].SizeA  = arrayConversationPairsSize;  
-      CE3Kpatterns[checkPatternIndex].SizeB  = arrayBlankSize;
-      CE3Kpatterns[checkPatternIndex].Width  = arrayConversationPairsWidth;   
-      CE3Kpatterns[checkPatternIndex].SubpixelResolution = 5;
-
-      // Done with defining patterns. Make sure that we defined them correctly.
-      checkPatternIndex++; // Because of zero-indexing, the count is one higher than the index.
-      if (checkPatternIndex != NUM_CE3K_PATTERNS)
-      {
-        while(true)
-        {
-          // Yell at myself if I don't update the code correctly.
-          Serial.println( F("-------------------------------------------------------------------------"));
-          Serial.println( F("Error - CE3K Scanner: NUM_CE3K_PATTERNS differs from pattern definitions."));
-          Serial.println( F("-------------------------------------------------------------------------"));
-          delay(5000);
-        }
-      }
+  uint32_t requested = (powerMilliwatts() * targetBrightness) / 256;
+  if (requested <= maxMilliwatts) return targetBrightness;
+  return ((uint32_t)targetBrightness * maxMilliwatts) / requested;
+}
+#endif
 
-      // Decide which of the patterns we'll be starting on, and prep it.
-      currentPatternIndex = 0;
-      currentPattern = CE3Kpatterns[currentPatternIndex];
-      updateDivTable(currentPatternIndex);
-    }
+// ---------------------------------------------------------------------------
+// Function to fetch the current row and the next row of a pair of byte-format
+// (CE3K_FORMAT_BYTES) pixel arrays, as darkness values, into the slitThisRow
+// and slitNextRow arrays.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::fetchSlitRowsBytes(const CE3Kpattern& pattern, long imageOffset)
+{
+  // Speed optimization: This used to be done one pixel at a time by a
+  // function called pixelValue(), which was called twice for every column of
+  // the slit, on every frame. That function had to keep hidden static state
+  // to track its position in each array, and it redid the wrap-around checks
+  // with "while" loops for every single pixel, falling back on an expensive
+  // modulo operation at certain points.
+  //
+  // Instead, this function works on an entire row at once. It resolves the
+  // start positions of the current row and the next row, in both of the
+  // arrays, just once per frame, using the modulo operator (%). The
+  // imageOffset cycles continuously through a very large range of numbers,
+  // and the "%" operator is the math that finds out what the array position
+  // would have been if it had started within this small array. This allows
+  // the code to support zigzag arrays of any size. Once the start positions
+  // are known, it streams the bytes of each row linearly out of the arrays,
+  // only stopping to wrap around when one of the read positions reaches the
+  // end of its array.
+  uint16_t width = pattern.Width;
+  uint16_t sizeA = pattern.SizeA;
+  uint16_t sizeB = pattern.SizeB;
+  const char* arrayA = (const char*)pattern.ArrayA;
+  const char* arrayB = (const char*)pattern.ArrayB;
+
+  // Also cast the modulo operations to unsigned ints to speed those up.
+  uint16_t thisIndexA = (unsigned long)imageOffset % (unsigned int)sizeA;
+  uint16_t nextIndexA = (unsigned long)(imageOffset + width) % (unsigned int)sizeA;
+
+  // If only one array is used, then the second array will be empty and will
+  // have a size of zero. Detect this and use only the first array.
+  bool twoArrays = (sizeB > 0);
+  uint16_t thisIndexB = 0;
+  uint16_t nextIndexB = 0;
+  if (twoArrays)
+  {
+    thisIndexB = (unsigned long)imageOffset % (unsigned int)sizeB;
+    nextIndexB = (unsigned long)(imageOffset + width) % (unsigned int)sizeB;
+  }
 
-    // Cycle to the next scanner pattern at intervals.
-    EVERY_N_MILLISECONDS(CE3K_PATTERN_CHANGE_INTERVAL)
+  uint8_t* thisRow = &slitThisRow[0];
+  uint8_t* nextRow = &slitNextRow[0];
+  uint16_t x = 0;
+  while (x < width)
+  {
+    // Find the longest run of pixels that can be streamed before any of the
+    // read positions reaches the end of its array. For patterns whose array
+    // sizes are an exact multiple of the width, which is the normal case,
+    // this is always the whole row in one run.
+    uint16_t run = width - x;
+    if (sizeA - thisIndexA < run) { run = sizeA - thisIndexA; }
+    if (sizeA - nextIndexA < run) { run = sizeA - nextIndexA; }
+    if (twoArrays)
     {
-      if (colorCyclingIsOn)   // This variable globally toggles animations on and off.
-      {
-        imageOffset = 0;      // Must reset these variables when changing patterns
-        subPixelOffset = 0;   // in order to prevent positioning and indexing bugs.
-        currentPatternIndex ++;
-        if (currentPatternIndex >= NUM_CE3K_PATTERNS) { currentPatternIndex = 0; }
-        currentPattern = CE3Kpatterns[currentPatternIndex];    
-        updateDivTable(currentPatternIndex);
-      }
+      if (sizeB - thisIndexB < run) { run = sizeB - thisIndexB; }
+      if (sizeB - nextIndexB < run) { run = sizeB - nextIndexB; }
     }
 
-    // Sanity check that I remembered to set WIDEST_ARRAY correctly.
-    if (currentPattern.Width > WIDEST_ARRAY)
+    // Convert the binary 0 or 1 value into a pixel darkness value, i.e., 0
+    // becomes 0, 1 becomes full brightness. Patterns with shades of gray use
+    // the CE3K_FORMAT_GRAY format instead.
+    const char* thisA = &arrayA[thisIndexA];
+    const char* nextA = &arrayA[nextIndexA];
+    uint16_t count = run;
+    if (twoArrays)
     {
-      while(true)
+      // This is where the code ANDs the two arrays together so that any black
+      // stripes are preserved, simulating the original fiber optic effect,
+      // where the photosensor controlling the fiber optic light is blocked by
+      // the pattern(s).
+      const char* thisB = &arrayB[thisIndexB];
+      const char* nextB = &arrayB[nextIndexB];
+      while (count--)
       {
-        // Yell at myself if I didn't update WIDEST_ARRAY correctly.
-        Serial.println( F("-------------------------------------------------------------------------"));
-        Serial.println( F("Error - CE3K Scanner: currentPattern width is wider than WIDEST_ARRAY."));
-        Serial.println( F("-------------------------------------------------------------------------"));
-        delay(5000);
+        *(thisRow++) = (pgm_read_byte(thisA++) & pgm_read_byte(thisB++)) ? 255 : 0;
+        *(nextRow++) = (pgm_read_byte(nextA++) & pgm_read_byte(nextB++)) ? 255 : 0;
       }
-    }  
-
-    // The "weight unit" is a percentage number representing the "thickness" of 1
-    // unit of subpixel resolution. For example if the subpixel resolution is set
-    // to 5, then each one of these units would be 0.20. The "weight" is this
-    // times the subpixel offset, so that the "weight" of each anti-aliased step
-    // is a smooth linear brightness transition between each line: 0.00, 0.20,
-    // 0.40, 0.60, 0.80. Note that 1.00 is skipped in the loops because that ends
-    // up being the same as the 0.00 for the following iteration. If it actually
-    // did both 0.00 and 1.00, it would work, but it would cause a short "pause"
-    // in the animation where the two similar frames met. The blend is based on:
-    // http://www.designimage.co.uk/quick-tip-the-maths-to-blend-between-two-values/
-    //    float oneSubPixelWeightUnit = ((float)1 / (float)currentPattern.SubpixelResolution);
-    //    float blendWeight = subPixelOffset * oneSubPixelWeightUnit;
-
-    // Speed optimization: Changing the blending code to a non-floating-point and
-    // non-division version of the blending weight code. Intended to make the
-    // loops run slightly faster by using pure integer math in the main loop.
-    // Instead of the weighting being done by a floating point percentage, it's
-    // now an integer value that is represented by a number from 0-255. For
-    // instance, if the subpixel resolution is at 5 for this particular pattern,
-    // then the first level of the five subpixel weighting values will be 51
-    // instead of 0.20. These values are stored in a lookup table which is
-    // recalculated once at the beginning of each pattern display. This way, the
-    // division operation is replaced by this quick div256Table lookup, saving
-    // dozens of CPU cycles per loop.
-    uint8_t blendWeight = div256Table[subPixelOffset];
-
-    // TO DO: The blend above (regardless of whether it's done with the floating
-    // point or the lookup table) is a purely linear blend. Unfortunately the
-    // LEDs do not have a purely linear brightness based on the numbers pumped
-    // into them. The lowest brightness level of an LED is significantly brighter
-    // than when the LED is just "off". This makes the antialiased pixels kind
-    // of "pop" from fully dark to dimly-lit in the final animation. This causes
-    // the transition points between black background and the white bars to seem
-    // to "caterpillar" across the strand instead of flowing perfectly smoothly.
-    // It would be nice if I could come up with a nonlinear blend to make it seem
-    // more smooth.
-
-    // Assemble the current slit view into the slit array. This loop is using
-    // a speed optimization where decrementing the uint16_t is faster than
-    // incrementing and testing an int with a For loop.
-    uint16_t x = currentPattern.Width;
-    if (currentPattern.Width <= 0) return;
-    while (x--)
-    {
-      // Obtain the current pixel location, and also the pixels on the prior row
-      // and the following row (for antialiasing).
-      long thisPixelPosition = x+imageOffset;
-      long nextPixelPosition = thisPixelPosition+currentPattern.Width;
-
-      // Get the value of the pixels of the image arrays. 
-      int thisPixelDarkness = pixelValue(thisPixelPosition, currentPattern.ArrayA, currentPattern.SizeA, currentPattern.ArrayB, currentPattern.SizeB);
-      int nextPixelDarkness = pixelValue(nextPixelPosition, currentPattern.ArrayA, currentPattern.SizeA, currentPattern.ArrayB, currentPattern.SizeB);
-
-      // Blend the next and previous line's pixels into the current line's pixel.
-      // I tried using FastLED's "blend8" function, but it did not produce the
-      // results I wanted. This is my own blend math, based on this:
-      // http://www.designimage.co.uk/quick-tip-the-maths-to-blend-between-two-values/
-      //    int blendedDarkness = (nextPixelDarkness*blendWeight)+(thisPixelDarkness*(1-blendWeight));
-
-      // Speed optimization: Integer-math version of the floating point blend
-      // above. Multiply by the blend weight as described above, but multiply it
-      // into a 16-bit integer and then bitshift it back down to 8 bits.
-      uint8_t blendedDarkness = (((uint16_t)nextPixelDarkness*blendWeight) >> 8)+(((uint16_t)thisPixelDarkness*(256-blendWeight)) >> 8);
-
-      // Apply the final values to the array that represents the slit. I'm using
-      // only the White LED in the CRGBW array here, so the colored conversation
-      // lights can be painted separately without having to blend them with the
-      // white LEDs. If you are using CRGB LEDs, you'll have to refactor this.
-      zigzagSlit[x].white = blendedDarkness;
-    }
-
-    // Copy the slit array onto the entire LED strand. If the current width is
-    // less than the total number of LEDs, then it will copy it multiple times.
-    // If the current width is larger than the total number of LEDs, it will
-    // copy only the relevant subsection. More details and example found here:
-    // https://github.com/marmilicious/FastLED_examples/blob/master/memmove8_pattern_copy.ino
-
-    // This code has had some speed optimizations made. Originally it was an
-    // incrementing for/next loop, and in the middle of the loop there was
-    // an "if" test every time to determine if the copied data would exceed the
-    // end of the strand. Instead, here it has been changed to a descending
-    // while loop so that its test condition runs faster. Also the variables
-    // have been changed to uints instead of ints to make things faster. And
-    // the "if" test no longer runs every loop, instead it copies leftover
-    // pixels at the end of the strand when the loop is done. It knows whether
-    // there are leftover pixels to copy, because the costly division
-    // operations have been pre-calculated in the "updateDivTable" routine,
-    // instead of being done every time through the loop.
-    uint16_t patternWidth = (uint16_t)currentPattern.Width;
-    uint16_t n = 0;
-    uint16_t copiedPatterns = slitCopyFullRepeatsCount;
-    while (copiedPatterns--)
-    {
-      // Copy the slit array to the LED strand. Syntax of this command is:    
-      // memmove8( &destination[start position], &source[start position], size of pixel data )      
-      // If you want to see just the color flashes and not the white scanner
-      // lights, either comment out the memmove8 lines, or set SCANNER_BRIGHTNESS 0.
-      memmove8(&leds[n], &zigzagSlit[0], patternWidth * sizeof(CRGBW));
-      n += patternWidth;
+      thisIndexB += run; if (thisIndexB >= sizeB) { thisIndexB = 0; }
+      nextIndexB += run; if (nextIndexB >= sizeB) { nextIndexB = 0; }
     }
-    if (slitCopyRemainingLeds > 0)
+    else
     {
-      // Handle the final leftover slice (if the pattern doesn't divide evenly).
-      memmove8(&leds[n], &zigzagSlit[0], slitCopyRemainingLeds * sizeof(CRGBW));
-    }
-
-    // Increment to the next line in the image (by fractional sub-pixel).
-    // First check the variable which globally toggles animations on and off.
-    if (colorCyclingIsOn)
-    {
-      subPixelOffset ++;
-    }
-
-    // This comparison must be ">=" rather than just ">", in order to prevent a
-    // small pause in the animation. The pause occurs if the subpixel offset
-    // number can be at the maximum value in one frame and then also be 0 in the
-    // next frame. For instance with a subpixel resolution of 5, it would go
-    // 012345 012345 012345, making the blend values for each animation go 0%,
-    // 20%, 40%, 60%, 80%, 100% each cycle. The 100% blend value in that last
-    // frame would match the 0% in the next cycle, and so the brightness of the
-    // pixel would be the same in both the "0" and the "5" frames because the
-    // blend results would be the same in both frames, and the animation would
-    // not seem to advance during that frame. This causes a noticeable "frame
-    // judder". Instead, it must skip the top value. For instance, with subpixel
-    // resolution of 5, it must go 01234 01234. That makes the blend values wrap
-    // around correctly at the ends of each cycle.
-    if (subPixelOffset >= currentPattern.SubpixelResolution)
-    {
-      // If we have progressed through all of the subpixels, then it's time to
-      // move on to the next line in the image.
-      subPixelOffset = 0;
-      imageOffset += currentPattern.Width; 
-
-      // The imageOffset is a long int, which goes up to 2147483647, which will
-      // take a long long time for this particular code. In any case, we still
-      // need to ensure this never crashes by resetting imageOffset back to 0 if
-      // it is allowed to get large (for example, if the code is configured to
-      // run a single pattern forever and never changes). The reset does not look
-      // smooth, but it will happen super-rarely. Still, it must get reset at
-      // some point, so that its value never wraps to negative. Note that the
-      // comparison can't be ">= 2147483647" because the variable will not ever
-      // reach that number before the variable wraps to negative (since it's
-      // incremented by pattern width rather than incremented by one). So give
-      // the variable some headroom by resetting the value well before it reaches
-      // that number.
-
-      //    if ( (imageOffset + currentPattern.Width) >= 1600 )    // Test-Debug a small reset point.
-      if ( (imageOffset + currentPattern.Width) >= 2147480000 )    // Reset before it reaches too close to the Long Int limit.
+      // If only one array is being used, then just use that byte in the array.
+      while (count--)
       {
-        imageOffset = 0;
-        subPixelOffset = 0;
-        // Serial.println (F("CE3K animation has wrapped around."));    // Test-Debug message to be notified of the reset point.
+        *(thisRow++) = pgm_read_byte(thisA++) ? 255 : 0;
+        *(nextRow++) = pgm_read_byte(nextA++) ? 255 : 0;
       }
-    }   
-  }  // This bracket ends the "EVERY_N_MILLISECONDS" for the scanner animation frames.
+    }
+    thisIndexA += run; if (thisIndexA >= sizeA) { thisIndexA = 0; }
+    nextIndexA += run; if (nextIndexA >= sizeA) { nextIndexA = 0; }
+    x += run;
+  }
+}
 
-  // Check the variable which globally toggles animations on and off.
-  if (colorCyclingIsOn)
+// ---------------------------------------------------------------------------
+// Function to expand one row's worth of bit-packed pixels, 32 at a time, into
+// darkness values. Used by fetchSlitRowsPacked() below.
+// ---------------------------------------------------------------------------
+void expandPackedRow(const uint32_t* rowA, const uint32_t* rowB, uint8_t* darkness, uint16_t width)
+{
+  uint16_t wordsPerRow = (width + 31) >> 5;
+  for (uint16_t word = 0; word < wordsPerRow; word++)
   {
-    // Call the subroutine to add the color conversation flashes. If you wish to
-    // see only the scanner lines and not the color flashes, then comment out
-    // this line, or set CONVERSATION_BRIGHTNESS 0.
-    CE3Kconversation();
+    // This is where the code ANDs the two arrays together so that any black
+    // stripes are preserved, 32 pixels at a time. If only one array is used,
+    // the "B" row is the same as the "A" row, and ANDing a word with itself
+    // leaves it unchanged.
+    uint32_t bits = pgm_read_dword(&rowA[word]) & pgm_read_dword(&rowB[word]);
+
+    uint8_t count = (width > 32) ? 32 : width;
+    width -= count;
+
+    // Speed optimization: Large parts of most patterns are solid black or
+    // solid white. Those words can be filled in without looking at the
+    // individual bits.
+    uint32_t usedBits = (count == 32) ? 0xFFFFFFFF : (((uint32_t)1 << count) - 1);
+    if (bits == 0 || bits == usedBits)
+    {
+      memset(darkness, bits ? 255 : 0, count);
+      darkness += count;
+      continue;
+    }
+
+    // Expand the bits of this word, one pixel per bit.
+    while (count--)
+    {
+      *(darkness++) = (bits & 1) ? 255 : 0;
+      bits >>= 1;
+    }
   }
 }
 
+// ---------------------------------------------------------------------------
+// Function to fetch the current row and the next row of a pair of bit-packed
+// (CE3K_FORMAT_PACKED) pixel arrays, as darkness values, into the slitThisRow
+// and slitNextRow arrays.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::fetchSlitRowsPacked(const CE3Kpattern& pattern, long imageOffset)
+{
+  // In the packed format every row starts on a fresh 32-bit word, so instead
+  // of tracking pixel positions, this only needs to know which row of each
+  // array is the current row and which is the next row. The imageOffset is
+  // always a whole number of rows, so a single modulo and division per array
+  // finds the current row, and the next row is one more than that, wrapping
+  // back around to the top of the array after the last row.
+  uint16_t width       = pattern.Width;
+  uint16_t wordsPerRow = (width + 31) >> 5;
+  const uint32_t* arrayA = (const uint32_t*)pattern.ArrayA;
+  const uint32_t* arrayB = (const uint32_t*)pattern.ArrayB;
+
+  uint16_t thisRowA = ((unsigned long)imageOffset % (unsigned int)pattern.SizeA) / width;
+  uint16_t nextRowA = thisRowA + 1;
+  if (nextRowA >= (uint16_t)(pattern.SizeA / width)) { nextRowA = 0; }
+  const uint32_t* thisA = &arrayA[thisRowA * wordsPerRow];
+  const uint32_t* nextA = &arrayA[nextRowA * wordsPerRow];
+
+  // If only one array is used, then the second array will be empty and will
+  // have a size of zero. Detect this and use only the first array.
+  const uint32_t* thisB = thisA;
+  const uint32_t* nextB = nextA;
+  if (pattern.SizeB > 0)
+  {
+    uint16_t thisRowB = ((unsigned long)imageOffset % (unsigned int)pattern.SizeB) / width;
+    uint16_t nextRowB = thisRowB + 1;
+    if (nextRowB >= (uint16_t)(pattern.SizeB / width)) { nextRowB = 0; }
+    thisB = &arrayB[thisRowB * wordsPerRow];
+    nextB = &arrayB[nextRowB * wordsPerRow];
+  }
+
+  expandPackedRow(thisA, thisB, slitThisRow, width);
+  expandPackedRow(nextA, nextB, slitNextRow, width);
+}
+
+// ---------------------------------------------------------------------------
+// Decode one row of a run-length (CE3K_FORMAT_RLE) pixel array into "row", as
+// darkness values. The row index takes us straight to the row's runs. With
+// "overlay" set, only the dark runs are written, which ANDs the row onto the
+// one that is already there, the same way that the black stripes of two
+// overlaid arrays are preserved in the other formats.
+// ---------------------------------------------------------------------------
+void decodeRleRow(const uint8_t* array, uint16_t rowNumber, uint8_t* row, uint16_t width, bool overlay)
+{
+  uint16_t offset = pgm_read_byte(&array[rowNumber * 2]) | ((uint16_t)pgm_read_byte(&array[(rowNumber * 2) + 1]) << 8);
+  const uint8_t* runs = &array[offset];
+  uint16_t x = 0;
+  while (x < width)
+  {
+    // Dark run, then lit run. Either one may be zero pixels long.
+    uint8_t run = pgm_read_byte(runs++);
+    memset(&row[x], 0, run);
+    x += run;
+    if (x >= width) break;
+    run = pgm_read_byte(runs++);
+    if (!overlay) { memset(&row[x], 255, run); }
+    x += run;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Function to fetch the current row and the next row of a pair of run-length
+// (CE3K_FORMAT_RLE) pixel arrays, as darkness values, into the slitThisRow
+// and slitNextRow arrays.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::fetchSlitRowsRle(const CE3Kpattern& pattern, long imageOffset)
+{
+  // The rows are found the same way as in the packed format: the imageOffset
+  // is always a whole number of rows, so a single modulo and division per
+  // array finds the current row, and the next row is one more than that.
+  // Only those two rows of each array are decoded.
+  uint16_t width = pattern.Width;
+  const uint8_t* arrayA = (const uint8_t*)pattern.ArrayA;
+  const uint8_t* arrayB = (const uint8_t*)pattern.ArrayB;
+
+  uint16_t thisRowA = ((unsigned long)imageOffset % (unsigned int)pattern.SizeA) / width;
+  uint16_t nextRowA = thisRowA + 1;
+  if (nextRowA >= (uint16_t)(pattern.SizeA / width)) { nextRowA = 0; }
+  decodeRleRow(arrayA, thisRowA, slitThisRow, width, false);
+  decodeRleRow(arrayA, nextRowA, slitNextRow, width, false);
+
+  // If only one array is used, then the second array will be empty and will
+  // have a size of zero. Detect this and use only the first array.
+  if (pattern.SizeB > 0)
+  {
+    uint16_t thisRowB = ((unsigned long)imageOffset % (unsigned int)pattern.SizeB) / width;
+    uint16_t nextRowB = thisRowB + 1;
+    if (nextRowB >= (uint16_t)(pattern.SizeB / width)) { nextRowB = 0; }
+    decodeRleRow(arrayB, thisRowB, slitThisRow, width, true);
+    decodeRleRow(arrayB, nextRowB, slitNextRow, width, true);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Function to fetch the current row and the next row of a pair of grayscale
+// (CE3K_FORMAT_GRAY) pixel arrays into the slitThisRow and slitNextRow arrays.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::fetchSlitRowsGray(const CE3Kpattern& pattern, long imageOffset)
+{
+  // Grayscale arrays are laid out the same as byte-format arrays, so the row
+  // positions are found the same way: once per frame with a modulo, then the
+  // bytes of each row are streamed linearly. Grayscale arrays must be a whole
+  // number of rows, so a row never wraps around partway through.
+  uint16_t width = pattern.Width;
+  const uint8_t* arrayA = (const uint8_t*)pattern.ArrayA;
+  const uint8_t* arrayB = (const uint8_t*)pattern.ArrayB;
+  const uint8_t* thisA = &arrayA[(unsigned long)imageOffset % (unsigned int)pattern.SizeA];
+  const uint8_t* nextA = &arrayA[(unsigned long)(imageOffset + width) % (unsigned int)pattern.SizeA];
+  uint8_t* thisRow = &slitThisRow[0];
+  uint8_t* nextRow = &slitNextRow[0];
+  uint16_t count = width;
+
+  // If only one array is used, then the second array will be empty and will
+  // have a size of zero. Detect this and use only the first array.
+  if (pattern.SizeB > 0)
+  {
+    // Overlay the two arrays by multiplying them together, as if light were
+    // shining through two partly transparent cutouts in a row. scale8 treats
+    // 255 as fully transparent, so 255 over 255 is still 255.
+    const uint8_t* thisB = &arrayB[(unsigned long)imageOffset % (unsigned int)pattern.SizeB];
+    const uint8_t* nextB = &arrayB[(unsigned long)(imageOffset + width) % (unsigned int)pattern.SizeB];
+    while (count--)
+    {
+      *(thisRow++) = scale8(pgm_read_byte(thisA++), pgm_read_byte(thisB++));
+      *(nextRow++) = scale8(pgm_read_byte(nextA++), pgm_read_byte(nextB++));
+    }
+  }
+  else
+  {
+    memcpy_P(thisRow, thisA, width);
+    memcpy_P(nextRow, nextA, width);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Build the lookup table which applies the SCANNER_GAMMA curve and the
+// SCANNER_BRIGHTNESS level to the blended slit pixels. This uses slow
+// floating point math, so it is only done once, at startup.
+// ---------------------------------------------------------------------------
+void updateGammaTable()
+{
+  for (uint16_t level = 0; level < 256; level++)
+  {
+    scannerGammaTable[level] = (uint8_t)(pow((float)level / 255, SCANNER_GAMMA) * SCANNER_BRIGHTNESS + 0.5);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Function to assemble one complete "slit" view of the zigzag pixel array(s)
+// into the zigzagSlit array, blending the current row of the pattern with the
+// following row for subpixel antialiasing.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::assembleSlitRow(const CE3Kpattern& pattern, long imageOffset, uint8_t blendWeight)
+{
+  // Fetch the two rows with the streaming code for the storage format of
+  // this pattern's arrays.
+  if (pattern.Format == CE3K_FORMAT_PACKED)
+  {
+    fetchSlitRowsPacked(pattern, imageOffset);
+  }
+  else if (pattern.Format == CE3K_FORMAT_GRAY)
+  {
+    fetchSlitRowsGray(pattern, imageOffset);
+  }
+  else if (pattern.Format == CE3K_FORMAT_RLE)
+  {
+    fetchSlitRowsRle(pattern, imageOffset);
+  }
+  else
+  {
+    fetchSlitRowsBytes(pattern, imageOffset);
+  }
+
+  // Blend the next and previous line's pixels into the current line's pixel.
+  // I tried using FastLED's "blend8" function, but it did not produce the
+  // results I wanted. This is my own blend math, based on this:
+  // http://www.designimage.co.uk/quick-tip-the-maths-to-blend-between-two-values/
+  //    int blendedDarkness = (nextPixelDarkness*blendWeight)+(thisPixelDarkness*(1-blendWeight));
+  //
+  // The integer-math version of this blend, and the SIMD versions of it for
+  // processors which have them, are in "Close_Encounters_Blend.h".
+  //
+  // The blend is a purely linear blend, done in perceptual brightness units.
+  // The results are converted into LED values with the gamma table, so that
+  // the antialiased edges of the white bars fade in and out smoothly instead
+  // of seeming to "caterpillar" across the strand. This is one table lookup
+  // per pixel of the slit, rather than any per-pixel math. How the results
+  // are stored in the slit depends on the type of LED strip, see CE3KpixelOps.
+  CE3KledOps::blendRows(slitThisRow, slitNextRow, blendWeight, zigzagSlit, pattern.Width);
+}
+
+// ---------------------------------------------------------------------------
+// Composite all of the running flashes into a list of non-overlapping spans,
+// in order along the strand, so that each pixel is painted at most once no
+// matter how many bars overlap it. Lit pixels win over dark ones, fully lit
+// pixels win over the soft end pixels of other bars, and where two bars
+// overlap otherwise, the one later in the pool is on top. The work done here
+// depends only on the size of the pool, not on the widths of the bars.
+// Returns the number of spans.
+// ---------------------------------------------------------------------------
+uint8_t CE3Kscanner::compositeFlashSpans(CE3KflashSpan* spans)
+{
+  // Work out the bar and the lit part of the bar for each running flash. The
+  // lit pixels are the ones past the center minus the swell width, up to and
+  // including the center plus the swell width, limited to the bar itself.
+  // With soft edges, the pixel just outside the lit part at each end is lit
+  // at the fraction of the swell width beyond the whole number of pixels.
+  int     barStart[CONVERSATION_MAX_FLASHES];
+  int     barEnd[CONVERSATION_MAX_FLASHES];
+  int     litStart[CONVERSATION_MAX_FLASHES];
+  int     litEnd[CONVERSATION_MAX_FLASHES];
+  int     softStart[CONVERSATION_MAX_FLASHES];   // Soft end pixel before the lit part, or -1 if none.
+  int     softEnd[CONVERSATION_MAX_FLASHES];     // Soft end pixel after the lit part, or -1 if none.
+  CRGB    softColor[CONVERSATION_MAX_FLASHES];
+  int     edges[CE3K_MAX_FLASH_SPANS];
+  uint8_t numEdges = 0;
+  for (uint8_t f = 0; f < CONVERSATION_MAX_FLASHES; f++)
+  {
+    const CE3Kflash& flash = flashes[f];
+    barStart[f] = barEnd[f] = litStart[f] = litEnd[f] = 0;
+    softStart[f] = softEnd[f] = -1;
+    if (flash.Stage < 1 || flash.Width < 0) continue;
+
+#if CONVERSATION_SOFT_EDGES
+    // The swell width, partway from the previous animation frame to this
+    // one, in 1/256ths of a pixel. It is half of the Stage, the same as
+    // TempWidth.
+    long stage256 = ((long)flash.PrevStage << 8) +
+                    (((long)(flash.Stage - flash.PrevStage) << 8) * conversationElapsed) / CONVERSATION_FLASH_SPEED;
+    long swell256 = (stage256 > 0) ? (stage256 >> 1) : 0;
+    int  tempWidth = swell256 >> 8;
+    uint8_t softLevel = swell256 & 0xFF;
+#else
+    int  tempWidth = flash.TempWidth;
+    uint8_t softLevel = 0;
+#endif
+
+    barStart[f] = flash.StartPoint;
+    barEnd[f]   = flash.StartPoint + flash.Width + 1;
+    litStart[f] = flash.StartPoint + flash.HalfWayMark - tempWidth + 1;
+    litEnd[f]   = flash.StartPoint + flash.HalfWayMark + tempWidth + 1;
+    if (litStart[f] < barStart[f]) { litStart[f] = barStart[f]; }
+    if (litEnd[f]   > barEnd[f])   { litEnd[f]   = barEnd[f]; }
+    if (litEnd[f]   < litStart[f]) { litEnd[f]   = litStart[f]; }
+
+    edges[numEdges++] = barStart[f];
+    edges[numEdges++] = barEnd[f];
+    edges[numEdges++] = litStart[f];
+    edges[numEdges++] = litEnd[f];
+
+    if (softLevel > 0)
+    {
+      // The light of a partly covered pixel is that fraction of the light of
+      // a fully lit one; the LED values are linear in light, so this is a
+      // straight scale of the color.
+      softColor[f].red   = scale8(flash.Color.red,   softLevel);
+      softColor[f].green = scale8(flash.Color.green, softLevel);
+      softColor[f].blue  = scale8(flash.Color.blue,  softLevel);
+      if (litStart[f] > barStart[f])
+      {
+        softStart[f] = litStart[f] - 1;
+        edges[numEdges++] = softStart[f];
+      }
+      if (litEnd[f] < barEnd[f])
+      {
+        softEnd[f] = litEnd[f];
+        edges[numEdges++] = softEnd[f] + 1;
+      }
+    }
+  }
+
+  // Sort the edges. There are only a handful, so an insertion sort is fine.
+  for (uint8_t i = 1; i < numEdges; i++)
+  {
+    int edge = edges[i];
+    uint8_t j = i;
+    while (j > 0 && edges[j - 1] > edge) { edges[j] = edges[j - 1]; j--; }
+    edges[j] = edge;
+  }
+
+  // Each piece between two neighboring edges is covered by the same set of
+  // bars all the way across, so only its first pixel needs to be checked.
+  uint8_t numSpans = 0;
+  for (uint8_t e = 1; e < numEdges; e++)
+  {
+    int pieceStart = edges[e - 1];
+    int pieceEnd   = edges[e];
+    if (pieceStart == pieceEnd) continue;
+
+    bool covered = false;
+    bool lit     = false;
+    CRGB color(0, 0, 0);
+    for (int8_t f = CONVERSATION_MAX_FLASHES - 1; f >= 0; f--)
+    {
+      if (pieceStart >= litStart[f] && pieceStart < litEnd[f])
+      {
+        // Lit pixels get the full color of the flash with soft edges. With
+        // the original hard edges, they get the color of the flash times a
+        // brightness of 255, the same as the original pixel-by-pixel
+        // painting code, so the bars look exactly as they always did.
+        covered = true;
+        lit     = true;
+#if CONVERSATION_SOFT_EDGES
+        color   = flashes[f].Color;
+#else
+        color.red   = flashes[f].Color.red * 255;
+        color.green = flashes[f].Color.green * 255;
+        color.blue  = flashes[f].Color.blue * 255;
+#endif
+        break;
+      }
+      if (pieceStart >= barStart[f] && pieceStart < barEnd[f])
+      {
+        covered = true;
+      }
+    }
+#if CONVERSATION_SOFT_EDGES
+    for (int8_t f = CONVERSATION_MAX_FLASHES - 1; f >= 0 && !lit; f--)
+    {
+      if (pieceStart == softStart[f] || pieceStart == softEnd[f])
+      {
+        lit   = true;
+        color = softColor[f];
+      }
+    }
+#endif
+    if (!covered) continue;
+
+    // Merge with the previous span if it continues it seamlessly.
+    if (numSpans > 0)
+    {
+      CE3KflashSpan& previous = spans[numSpans - 1];
+      if (previous.End == pieceStart && previous.Lit == lit &&
+          previous.Color.red == color.red && previous.Color.green == color.green && previous.Color.blue == color.blue)
+      {
+        previous.End = pieceEnd;
+        continue;
+      }
+    }
+    CE3KflashSpan& span = spans[numSpans++];
+    span.Start = pieceStart;
+    span.End   = pieceEnd;
+    span.Lit   = lit;
+    span.Color = color;
+  }
+  return numSpans;
+}
+
+// ---------------------------------------------------------------------------
+// Play one frame of the animation of the colored flashing "conversation"
+// lights, which appear atop the moving white "idle" animation bars. The
+// original colored lights in the film were hand-animated by Robert Swarthe,
+// this attempts to simulate their style. The frame scheduler in update()
+// calls this once for every CONVERSATION_FLASH_SPEED milliseconds which have
+// passed, and then paintConversation() paints the result onto the strand.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::stepConversation()
+{
+  // Each color flash has to go through several frames of animation for the
+  // entire flash. Keep track of both things with the variable "Stage" of each
+  // flash: Stage 0 means that the flash is idle, Stage nonzero means that it
+  // is in the middle of a color flash animation. Each time a frame of the
+  // animation is played, it increments or decrements the Stage variable
+  // (incrementing when the color bar is swelling up to its full length,
+  // decrementing when it's unswelling down to nothing). A separate variable,
+  // Frames, keeps track of the number of swelling frames in this animation
+  // (each flash will have a different size and thus a different number of
+  // frames). Then if Stage reaches Frames, that means it's the last frame of
+  // the swell-up animation and it then dwells for a bit, then switches
+  // direction and decrements down to zero. Once it hits zero, then the
+  // animation is done and that flash waits until it is triggered again.
+  //
+  // In the film, there are some moments in the scene where multiple color
+  // flashes occur at the same time, so there is a pool of flashes, of size
+  // CONVERSATION_MAX_FLASHES, which are all animated in a single pass.
+
+#if CE3K_CONVERSATION_EPOCH > 0
+  // Each conversation epoch starts over, with no flashes and a fresh seed,
+  // and no new flashes start near the end of an epoch, so that the last of
+  // them can finish before the next epoch starts (see CE3K_CONVERSATION_EPOCH).
+  uint16_t epochStep = conversationStep % CE3K_CONVERSATION_EPOCH_STEPS;
+  if (epochStep == 0)
+  {
+    for (uint8_t f = 0; f < CONVERSATION_MAX_FLASHES; f++)
+    {
+      flashes[f] = CE3Kflash();
+    }
+    randomSeed = ce3kEpochSeed(conversationSeed, conversationStep / CE3K_CONVERSATION_EPOCH_STEPS);
+  }
+  conversationStep++;
+  bool triedNewFlash = (epochStep >= CE3K_CONVERSATION_EPOCH_STEPS - CE3K_FLASH_MAX_STEPS);
+#else
+  bool triedNewFlash = false;
+#endif
+  for (uint8_t f = 0; f < CONVERSATION_MAX_FLASHES; f++)
+  {
+    CE3Kflash& flash = flashes[f];
+
+    // Remember where this flash was before this frame, for the soft edges.
+    flash.PrevStage = flash.Stage;
+
+    // If this flash is currently not in the middle of a flash animation,
+    // and no other idle flash has had its chance yet on this frame, decide
+    // whether this frame will begin a new flash animation.
+    if (flash.Stage < 1 && !triedNewFlash)
+    {
+      triedNewFlash = true;
+
+      // Flash animation decision is random, governed by this threshold.
+      // Generate a random number between 0 and 1000, and if the number is
+      // larger than the threshold, trigger a new color flash animation.
+      if (nextRandom16(1000) > CONVERSATION_FLASH_FREQUENCY)
+      {
+        // Begin the color flash animation.
+        flash.Stage        = 1;
+        flash.Increasing   = true;
+
+        // Randomize the size and position of the color bar flash.
+        flash.Width        = nextRandom16(CONVERSATION_FLASH_MAX_FRAMES) + CONVERSATION_FLASH_MIN_FRAMES;
+        flash.Dwell        = nextRandom16(CONVERSATION_EXTRA_DWELL_MAX); // Color bar can dwell at its widest point for a certain number of frames.
+        flash.StartPoint   = nextRandom16(CONVERSATION_START_POINT_MAX - CONVERSATION_START_POINT_MIN - flash.Width) + CONVERSATION_START_POINT_MIN;
+        flash.Hue          = nextRandom8();                          // Random hue for each color light flash.
+
+        // Ensure we do not overwrite memory by making sure the start/end points
+        // don't exceed the start or end of the LED strand. This should only be
+        // needed when running on a small test strip where the width of the
+        // color bars could become greater than the length of the strand.
+        if (flash.StartPoint < 0) { flash.StartPoint = 0; }
+        if (flash.StartPoint >= numLeds) { flash.StartPoint = nextRandom16(numLeds - flash.Width); }
+        if (flash.StartPoint + flash.Width >= numLeds) { flash.Width = numLeds - flash.StartPoint - 1; }
+
+        // Half way mark that defines the center of the color flash.
+        //   HalfWayMark = Width / 2;
+        // Speed optimization: Do a right bitwise shift by one position, which is
+        // a faster way to do a divide-by-2 with integer math on this chipset.
+        flash.HalfWayMark = flash.Width >> 1;
+
+        // Number of animation frames is the same as the color bar width.
+        flash.Frames = flash.Width;
+
+        // Create an HSV value based on the random hue, then convert HSV to RGB so
+        // that I can paint *just* the RGB values into the RGBW strip but *not*
+        // the W, which is responsible for the idle scanner effect.
+        CHSV colorBarhsv(flash.Hue, 255, CONVERSATION_BRIGHTNESS);
+        hsv2rgb_rainbow( colorBarhsv, flash.Color);
+      }
+    }
+
+    // Increment or decrement the animation frame, depending on the current
+    // stage of the flash animation we're in right now.
+    if (flash.Stage > 0)
+    {
+      // Increment or decrement the color flash animation frame we're in, which
+      // will control whether the color bar is swelling or unswelling.
+      if (flash.Increasing)
+      {
+        // The color bar swells to full width twice as quickly as it unswells.
+        // Since each color flash represents a musical note, this is like
+        // giving the note a sharper attack than the note's decay. This seems
+        // to look best. I asked Robert Swarthe if that's the way he did it,
+        // and he doesn't remember, but said that it sounds like something he'd
+        // probably do.
+        flash.Stage += CONVERSATION_FLASH_FRAMESKIP;
+        flash.Stage += CONVERSATION_FLASH_FRAMESKIP;
+      }
+      else
+      {
+        flash.Stage -= CONVERSATION_FLASH_FRAMESKIP;
+      }
+
+      // The distance from the center of the color flash that the pixels extend.
+      // This controls the swell size of the color bar. Basically the color bar
+      // is divided down the center, and it swells from that center point
+      // leftward towards the 0 mark of the color bar, and from the center
+      // point rightward toward the max mark of the color bar. This value
+      // controls how far from the center point it swells on this frame of the
+      // animation.
+      //   TempWidth = Stage / 2;
+      // Speed optimization: Do a right bitwise shift by one position, which is
+      // a faster way to do a divide-by-2 with integer math on this chipset.
+      flash.TempWidth = flash.Stage >> 1;
+
+      // If we have reached widest point of the color flash animation, either
+      // dwell at the widest point for a bit (like the sustain portion of a
+      // musical note), or switch direction so that it decreases the bar's
+      // width (like the decay portion of a musical note).
+      if (flash.Stage > flash.Frames)
+      {
+        if (flash.Dwell > 0)
+        {
+          // During the dwell period, Stage will keep getting
+          // double-incremented in an earlier step. By decrementing it here
+          // during the dwell, we keep it bumping up against the "wall" of the
+          // fully-extended bar width.
+          flash.Stage -= CONVERSATION_FLASH_FRAMESKIP;
+          flash.Stage -= CONVERSATION_FLASH_FRAMESKIP;
+          flash.Dwell -= CONVERSATION_FLASH_FRAMESKIP; // Count down the dwell towards zero.
+        }
+        else
+        {
+          // If there's no dwell, or if we're done with the dwell, then start
+          // decreasing the bar width instead of increasing it.
+          flash.Increasing = false;
+        }
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Subroutine to paint the current frame of the color conversation flashes
+// onto the LED strand, atop the white scanner bars.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::paintConversation()
+{
+  // The bars are first composited into spans, so that overlapping bars are
+  // painted in one sweep along the strand.
+  CE3KflashSpan spans[CE3K_MAX_FLASH_SPANS];
+  uint8_t numSpans = compositeFlashSpans(spans);
+
+  // Only the lit spans get painted. The dark parts of the bars are left
+  // alone, because any pixel that was lit on an earlier frame and isn't any
+  // more is erased below, using the list of spans that were painted before.
+  uint8_t numLitSpans = 0;
+  for (uint8_t s = 0; s < numSpans; s++)
+  {
+    if (spans[s].Lit) { spans[numLitSpans++] = spans[s]; }
+  }
+
+  // If the lit spans are exactly the same as the ones already painted, then
+  // there's nothing to do, and the frame hasn't changed. That's often the
+  // case, since the bars only move every CONVERSATION_FLASH_SPEED, and not
+  // at all between flashes.
+  bool spansChanged = (numLitSpans != numPaintedSpans);
+  for (uint8_t s = 0; s < numLitSpans && !spansChanged; s++)
+  {
+    const CE3KflashSpan& span = spans[s];
+    const CE3KflashSpan& painted = paintedSpans[s];
+    spansChanged = (span.Start != painted.Start || span.End != painted.End ||
+                    span.Color.red != painted.Color.red || span.Color.green != painted.Color.green || span.Color.blue != painted.Color.blue);
+  }
+  if (!spansChanged) return;
+
+  // Everything between the first and last pixel of the old and new spans may
+  // have changed.
+  for (uint8_t s = 0; s < numPaintedSpans; s++)
+  {
+    markDirty(paintedSpans[s].Start, paintedSpans[s].End - 1);
+  }
+  for (uint8_t s = 0; s < numLitSpans; s++)
+  {
+    markDirty(spans[s].Start, spans[s].End - 1);
+  }
+
+#if CE3K_POWER_ESTIMATE
+  // The bars are short, so the extra power they draw, over and above the
+  // slit pixels underneath them, is added up pixel by pixel.
+  uint32_t paintedPower   = 0;
+  uint32_t unpaintedPower = 0;
+  for (uint8_t s = 0; s < numLitSpans; s++)
+  {
+    uint16_t column = spans[s].Start % slitWidth;
+    for (int c = spans[s].Start; c < spans[s].End; c++)
+    {
+      CE3KledPixel pixel;
+      CE3KledOps::paint(pixel, zigzagSlit[column], spans[s].Color);
+      paintedPower   += CE3KledOps::power(pixel);
+      unpaintedPower += CE3KledOps::power(zigzagSlit[column]);
+      if (++column >= slitWidth) { column = 0; }
+    }
+  }
+  flashPower = paintedPower - unpaintedPower;
+#endif
+
+#if CE3K_ZERO_COPY_OUTPUT
+  // Zero-copy output: rather than painting the bars pixel by pixel, record
+  // the lit spans as patches. Nothing needs erasing, since the RGB values of
+  // the slit are always zero.
+  strandFrame.NumPatches = 0;
+  for (uint8_t s = 0; s < numLitSpans; s++)
+  {
+    CE3Kpatch& patch = strandFrame.Patches[strandFrame.NumPatches++];
+    patch.Start = spans[s].Start;
+    patch.Count = spans[s].End - spans[s].Start;
+    patch.Color = spans[s].Color;
+  }
+#else
+  // The strand underneath the bars is the slit array, repeated. Its pixels
+  // are needed both to erase the old bars and to paint the new ones, since
+  // on a CRGB strip the colors are added to the white scanner pixels.
+  const CE3KledPixel* slit  = &zigzagSlit[0];
+  uint16_t            width = slitWidth;
+
+  // Erase the pixels painted last time which aren't lit any more, back to
+  // the slit. The pixels which are still lit are painted over below, so they
+  // are skipped here. Both lists of spans are in order along the strand, so
+  // this is a single walk along the two of them.
+  uint8_t next = 0;
+  for (uint8_t s = 0; s < numPaintedSpans; s++)
+  {
+    int c   = paintedSpans[s].Start;
+    int end = paintedSpans[s].End;
+    while (c < end)
+    {
+      while (next < numLitSpans && spans[next].End <= c) { next++; }
+      int stop = end;
+      if (next < numLitSpans && spans[next].Start < end)
+      {
+        stop = (spans[next].Start > c) ? spans[next].Start : c;
+      }
+      if (stop > c)
+      {
+        CE3KledOps::eraseSpan(&leds[c], slit, c % width, width, stop - c);
+      }
+      if (stop >= end) break;
+      c = spans[next].End;
+    }
+  }
+
+  for (uint8_t s = 0; s < numLitSpans; s++)
+  {
+    // Apply the color flash to the LED strand, on top of the black and white
+    // "idle scanner" animation running in parallel to these color flashes. On
+    // a CRGBW strand this fills in only the RGB values and leaves the W value
+    // alone; on a CRGB strand the colors are added to the white pixels that
+    // are already there. Each span is one solid color, so it is filled in
+    // one go, and only the pixels of the bars are touched, so there is no
+    // second pass over the whole strand on either kind of strip.
+    const CE3KflashSpan& span = spans[s];
+    CE3KledOps::fillSpan(&leds[span.Start], slit, span.Start % width, width, span.End - span.Start, span.Color);
+  }
+#endif
+
+  // Remember what has been painted, for next time.
+  for (uint8_t s = 0; s < numLitSpans; s++)
+  {
+    paintedSpans[s] = spans[s];
+  }
+  numPaintedSpans = numLitSpans;
+}
+
+// ---------------------------------------------------------------------------
+// Erase all of the color conversation bars from the strand, back to the slit
+// underneath, for when the animations have been turned off. The flashes
+// themselves are kept, and carry on where they left off when the animations
+// are turned back on.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::eraseConversation()
+{
+  for (uint8_t s = 0; s < numPaintedSpans; s++)
+  {
+    const CE3KflashSpan& painted = paintedSpans[s];
+    markDirty(painted.Start, painted.End - 1);
+#if !CE3K_ZERO_COPY_OUTPUT
+    CE3KledOps::eraseSpan(&leds[painted.Start], &zigzagSlit[0], painted.Start % slitWidth, slitWidth, painted.End - painted.Start);
+#endif
+  }
+#if CE3K_ZERO_COPY_OUTPUT
+  strandFrame.NumPatches = 0;
+#endif
+#if CE3K_POWER_ESTIMATE
+  flashPower = 0;
+#endif
+  numPaintedSpans = 0;
+}
+
+#if CE3K_FRAME_CACHE_BYTES > 0
+// ---------------------------------------------------------------------------
+// Frame cache (see CE3K_FRAME_CACHE_BYTES).
+// ---------------------------------------------------------------------------
+#if CE3K_FRAME_CACHE_REPORT
+// Print the cache size and hit rate of the outgoing pattern to the serial
+// port, once after each pattern change. Call this from loop(), in between
+// frames rather than in the middle of one, through ce3kFrameCacheReport().
+void CE3Kscanner::reportFrameCache()
+{
+  if (!frameCacheReportDue) return;
+  frameCacheReportDue = false;
+  uint32_t total = reportHits + reportMisses;
+  Serial.print(F("CE3K frame cache: pattern "));
+  Serial.print(reportPatternIndex);
+  Serial.print(F(", cycle "));
+  Serial.print(reportPeriod);
+  Serial.print(F(" frames, cached "));
+  Serial.print(reportFrames);
+  Serial.print(F(" frames, hit rate "));
+  Serial.print(total ? (reportHits * 100) / total : 0);
+  Serial.print(F("% of "));
+  Serial.print(total);
+  Serial.println(F(" frames"));
+}
+#endif
+
+// Empty the cache for the current pattern. This is run each time a new
+// pattern is activated, after its scrollPeriodRows has been calculated. The
+// cache is filled in as the pattern runs, see readFrameCache().
+void CE3Kscanner::resetFrameCache()
+{
+  frameCacheHits   = 0;
+  frameCacheMisses = 0;
+  frameCachePeriod = 0;
+  frameCacheFrames = 0;
+  memset(frameCacheFilled, 0, sizeof(frameCacheFilled));
+
+  // Patterns with no known cycle length are always rendered live.
+  if (scrollPeriodRows == 0) return;
+  frameCachePeriod = (uint32_t)scrollPeriodRows * CE3K_FRAME_CACHE_STEPS;
+  frameCacheFrames = CE3K_FRAME_CACHE_BYTES / currentPattern.Width;
+  if (frameCacheFrames > frameCachePeriod) { frameCacheFrames = frameCachePeriod; }
+}
+
+// Fill the slit with the frame at this point in the cycle, rounded down to
+// the nearest blend step. If the frame has been cached, it is read from the
+// cache; if not, it is rendered live, with exactly the same code as any other
+// frame, and then kept in the cache for next time. Frames beyond what fits in
+// the cache are rendered live at the same rounded blend step, so the output
+// is the same whether or not a frame was in the cache. Returns false if the
+// pattern can't be cached at all, and has to be rendered live without any
+// rounding.
+bool CE3Kscanner::readFrameCache(const CE3Kpattern& pattern, uint32_t scrollPosition)
+{
+  if (frameCachePeriod == 0) return false;
+  uint16_t width = pattern.Width;
+  uint32_t row   = (scrollPosition >> 16) % scrollPeriodRows;
+  uint8_t  step  = ((scrollPosition >> 8) & 0xFF) * CE3K_FRAME_CACHE_STEPS / 256;
+  uint32_t frame = (row * CE3K_FRAME_CACHE_STEPS) + step;
+  if (frame >= frameCacheFrames)
+  {
+    frameCacheMisses++;
+    assembleSlitRow(pattern, (long)row * width, (step * 256) / CE3K_FRAME_CACHE_STEPS);
+    return true;
+  }
+
+  uint8_t* cached = &frameCache[frame * width];
+  CE3KledPixel* slit = &zigzagSlit[0];
+  uint8_t filledBit = 1 << (frame & 7);
+  if (frameCacheFilled[frame >> 3] & filledBit)
+  {
+    frameCacheHits++;
+    while (width--)
+    {
+      CE3KledOps::setWhite(*(slit++), *(cached++));
+    }
+  }
+  else
+  {
+    frameCacheMisses++;
+    assembleSlitRow(pattern, (long)row * width, (step * 256) / CE3K_FRAME_CACHE_STEPS);
+    while (width--)
+    {
+      *(cached++) = CE3KledOps::getWhite(*(slit++));
+    }
+    frameCacheFilled[frame >> 3] |= filledBit;
+  }
+  return true;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Greatest common divisor, used to find the least common multiple of the
+// heights of the two arrays of a pattern.
+// ---------------------------------------------------------------------------
+uint32_t greatestCommonDivisor(uint32_t a, uint32_t b)
+{
+  while (b != 0)
+  {
+    uint32_t remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+  return a;
+}
+
+// ---------------------------------------------------------------------------
+// Set the width of the slit view which gets copied onto the LED strip, and
+// precalculate how many copies of it fit along the strip.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::setSlitWidth(uint16_t width)
+{
+  slitWidth = width;
+  slitCopyFullRepeatsCount = numLeds / width;    // How many full, un-truncated blocks fit inside the strip.
+  slitCopyRemainingLeds = numLeds % width;       // Number of leftover pixels need to be copied for the last remainder.
+}
+
+// ---------------------------------------------------------------------------
+// Scroll position of the current pattern after it has been running for
+// "elapsed" milliseconds at its own speed, wrapped around the same way that
+// update() wraps it, but worked out in one step.
+// ---------------------------------------------------------------------------
+uint32_t CE3Kscanner::scrollPositionAt(uint32_t elapsed)
+{
+  if (scrollPeriodRows > 0)
+  {
+    return ((uint64_t)scrollSpeed * elapsed) % ((uint64_t)scrollPeriodRows << 16);
+  }
+  return scrollSpeed * elapsed;
+}
+
+// ---------------------------------------------------------------------------
+// Precalculate the values that depend on the current pattern, so that every
+// time through the animation loop, it doesn't run costly division operations
+// to get them. Only do these costly division operations once, each time a
+// new pattern is activated.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::activatePattern(int patternIndex)
+{
+#if CE3K_FRAME_CACHE_BYTES > 0 && CE3K_FRAME_CACHE_REPORT
+  // Keep the frame cache statistics of the outgoing pattern for the report.
+  if (frameCacheHits + frameCacheMisses > 0)
+  {
+    reportPatternIndex  = currentPatternIndex;
+    reportPeriod        = frameCachePeriod;
+    reportFrames        = frameCacheFrames;
+    reportHits          = frameCacheHits;
+    reportMisses        = frameCacheMisses;
+    frameCacheReportDue = true;
+  }
+#endif
+
+  // Copy the pattern out of the table in flash memory.
+  currentPatternIndex = patternIndex;
+  memcpy_P(&currentPattern, &CE3Kpatterns[patternIndex], sizeof(CE3Kpattern));
+  const CE3Kpattern& pattern = currentPattern;
+  scrollSpeed = pattern.Speed;
+
+  // These variables control the operation which copies each "slit" view of
+  // the patterns onto the full size of the entire LED strip.
+  uint16_t patternWidth = pattern.Width;
+  setSlitWidth(patternWidth);
+
+  // Number of rows before the pattern repeats exactly, which is the least
+  // common multiple of the heights of its two arrays. The scroll position
+  // wraps around at this point, so that it never overflows. This only works
+  // for arrays which are a whole number of rows tall; for any others, leave
+  // it at 0, and let the scroll position wrap around when it overflows.
+  scrollPeriodRows = 0;
+  if (pattern.SizeA % patternWidth == 0 && pattern.SizeB % patternWidth == 0)
+  {
+    uint32_t rows = pattern.SizeA / patternWidth;
+    if (pattern.SizeB > 0)
+    {
+      uint32_t rowsB = pattern.SizeB / patternWidth;
+      rows = (rows / greatestCommonDivisor(rows, rowsB)) * rowsB;
+    }
+    if (rows > 0 && rows <= 0xFFFF) { scrollPeriodRows = rows; }
+  }
+
+#if CE3K_FRAME_CACHE_BYTES > 0
+  // Start caching the new pattern's cycle of slit views from scratch.
+  resetFrameCache();
+#endif
+}
+
+#if CE3K_PATTERN_CROSSFADE > 0
+// ---------------------------------------------------------------------------
+// Change to another pattern with a crossfade (see CE3K_PATTERN_CROSSFADE).
+// The outgoing pattern is kept running, and the slit view is widened to a
+// width which both patterns repeat evenly across, so that each of them lines
+// up along the strand the same way it does on its own.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::crossfadeToPattern(int patternIndex)
+{
+  fadingPattern        = currentPattern;
+  fadingScrollPosition = scrollPosition;
+  fadingScrollSpeed    = scrollSpeed;
+  fadingPeriodRows     = scrollPeriodRows;
+
+  scrollPosition = 0;   // Must reset this variable when changing patterns
+                        // in order to prevent positioning and indexing bugs.
+  activatePattern(patternIndex);
+
+  // The blended slit repeats after the least common multiple of the two
+  // widths, and there's no need for it to be wider than the strand. The
+  // compiler has made the slit arrays wide enough for every pair of patterns
+  // which follow each other in the table; any other pair gets a hard cut.
+  uint32_t fromWidth = fadingPattern.Width;
+  uint32_t toWidth   = currentPattern.Width;
+  uint32_t width     = (fromWidth / greatestCommonDivisor(fromWidth, toWidth)) * toWidth;
+  if (width > numLeds) { width = numLeds; }
+  crossfading = (width <= SLIT_ARRAY_WIDTH);
+  if (crossfading)
+  {
+    crossfadeElapsed = 0;
+    setSlitWidth(width);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Move the crossfade along by the number of milliseconds since the previous
+// frame, and keep the outgoing pattern scrolling. Once the crossfade is over,
+// the slit view goes back to the width of the incoming pattern.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::advanceCrossfade(uint32_t elapsed)
+{
+  fadingScrollPosition += fadingScrollSpeed * elapsed;
+  if (fadingPeriodRows > 0 && (fadingScrollPosition >> 16) >= fadingPeriodRows)
+  {
+    fadingScrollPosition %= (uint32_t)fadingPeriodRows << 16;
+  }
+
+  // The crossfade started at the pattern change, so it has been running for
+  // as long as the incoming pattern has.
+  if (patternElapsed >= CE3K_PATTERN_CROSSFADE)
+  {
+    crossfading = false;
+    setSlitWidth(currentPattern.Width);
+  }
+  else
+  {
+    crossfadeElapsed = patternElapsed;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Replace the slit view of the incoming pattern, which has just been
+// assembled in the slit array, with the crossfade of the outgoing pattern
+// into the incoming one, across the whole width of the blended slit.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::crossfadeSlit()
+{
+  // Save the incoming slit view, then assemble the outgoing one in the slit
+  // array and save that too.
+  uint16_t toWidth = currentPattern.Width;
+  for (uint16_t x = 0; x < toWidth; x++)
+  {
+    crossfadeToSlit[x] = CE3KledOps::getWhite(zigzagSlit[x]);
+  }
+  uint16_t fromWidth = fadingPattern.Width;
+  assembleSlitRow(fadingPattern, (long)(fadingScrollPosition >> 16) * fromWidth, (fadingScrollPosition >> 8) & 0xFF);
+  for (uint16_t x = 0; x < fromWidth; x++)
+  {
+    crossfadeFromSlit[x] = CE3KledOps::getWhite(zigzagSlit[x]);
+  }
+
+  // Blend the two, with the same integer math as the blend between rows.
+  // These are LED values, after the SCANNER_GAMMA curve, so this is a
+  // straight mix of the light from the two patterns.
+  uint8_t  toWeight   = ((uint32_t)crossfadeElapsed * 256) / CE3K_PATTERN_CROSSFADE;
+  uint16_t fromWeight = 256 - toWeight;
+  uint16_t fromColumn = 0;
+  uint16_t toColumn   = 0;
+  for (uint16_t x = 0; x < slitWidth; x++)
+  {
+    CE3KledOps::setWhite(zigzagSlit[x], (((uint16_t)crossfadeToSlit[toColumn] * toWeight) >> 8) + (((uint16_t)crossfadeFromSlit[fromColumn] * fromWeight) >> 8));
+    if (++toColumn   >= toWidth)   { toColumn = 0; }
+    if (++fromColumn >= fromWidth) { fromColumn = 0; }
+  }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// One-time setup of a scanner, which draws on the "count" pixels starting at
+// "strand", and starts on the pattern at "patternIndex" in the pattern table.
+// Scanners which are set up with different seeds play different conversation
+// flashes. Call this once from the "setup()" of the main Arduino code, before
+// the first call to update(). Setting up a scanner again starts it over.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::setup(CE3KledPixel* strand, uint16_t count, int patternIndex, uint16_t seed)
+{
+  // Build the gamma lookup table for the white scanner bars, the first time
+  // that any scanner is set up.
+  if (!scannerGammaTableBuilt)
+  {
+    updateGammaTable();
+    scannerGammaTableBuilt = true;
+  }
+
+  leds       = strand;
+  numLeds    = count;
+  randomSeed       = seed;
+  conversationSeed = seed;
+#if CE3K_CONVERSATION_EPOCH > 0
+  conversationStep = 0;
+#endif
+
+  // Nothing is on the strand yet, and no flashes are running. The slit
+  // arrays are cleared too, so that a scanner which is set up again starts
+  // from the same state as a new one. (The pixels are plain bytes; the cast
+  // is only there because the pixel types declare their own assignment.)
+  memset((void*)zigzagSlit, 0, sizeof(zigzagSlit));
+  memset((void*)shownSlit,  0, sizeof(shownSlit));
+  shownSlitWidth  = 0;
+  numPaintedSpans = 0;
+  for (uint8_t f = 0; f < CONVERSATION_MAX_FLASHES; f++)
+  {
+    flashes[f] = CE3Kflash();
+  }
+  clearDirty();
+#if CE3K_ZERO_COPY_OUTPUT
+  strandFrame.Width      = 0;
+  strandFrame.NumPatches = 0;
+#endif
+#if CE3K_POWER_ESTIMATE
+  slitPower  = 0;
+  flashPower = 0;
+#endif
+#if CE3K_PATTERN_CROSSFADE > 0
+  crossfading = false;
+#endif
+#if CE3K_FRAME_CACHE_BYTES > 0
+  frameCacheHits   = 0;
+  frameCacheMisses = 0;
+#if CE3K_FRAME_CACHE_REPORT
+  frameCacheReportDue = false;
+#endif
+#endif
+
+  // Start on the chosen pattern, and prep it.
+  scrollPosition    = 0;
+  firstPatternIndex = patternIndex;
+  activatePattern(patternIndex);
+
+  // Start the frame scheduler, with the first frame one frame from now, and
+  // start the shared time from now.
+  lastFrameTime       = millis();
+  epochMillis         = lastFrameTime;
+  nextFrameTime       = lastFrameTime + SCANNER_ANIMATION_SPEED;
+  patternElapsed      = 0;
+  conversationElapsed = 0;
+  lateFrames          = 0;
+  onTimeFrames        = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Main loop of a scanner. This routine should be called once per "loop()" of
+// the main Arduino code, with the current value of millis(). This routine is
+// responsible for generating the moving white "idle" bars of the scanner
+// ring animation, and the color conversation flashes on top of them.
+//
+// Both animations are run by a single frame scheduler. Frames are due every
+// SCANNER_ANIMATION_SPEED milliseconds, on a fixed beat which doesn't drift
+// when a loop runs a little late. Each frame advances all of the animations
+// by the time which has actually passed since the previous frame: the
+// scrolling of the scanner bars, the crossfade, the pattern changes, and as
+// many CONVERSATION_FLASH_SPEED steps of the conversation flashes as are due.
+// Then it renders them all into one frame of the strand, so the sketch only
+// has to send the strand once per frame. See CE3K_OVERLOAD_FRAMES for what
+// happens when a frame is late.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::update(uint32_t now)
+{
+  // Nothing to do until the next frame is due. Most loops end here.
+  if ((int32_t)(now - nextFrameTime) < 0) return;
+
+  // If a whole frame or more has been missed, drop the missed frames and
+  // start the beat over from now, rather than trying to catch up, and count
+  // the late frame. Otherwise, stay on the beat, and forget the late frames
+  // once enough frames in a row have been on time.
+  if (now - nextFrameTime >= SCANNER_ANIMATION_SPEED)
+  {
+    nextFrameTime = now + SCANNER_ANIMATION_SPEED;
+    onTimeFrames  = 0;
+    if (lateFrames < CE3K_OVERLOAD_LATE_FRAMES) { lateFrames++; }
+  }
+  else
+  {
+    nextFrameTime += SCANNER_ANIMATION_SPEED;
+    if (lateFrames > 0 && ++onTimeFrames >= CE3K_OVERLOAD_FRAMES)
+    {
+      lateFrames   = 0;
+      onTimeFrames = 0;
+    }
+  }
+
+  // Time that has actually passed since the previous frame. A very long gap
+  // (for example, while debugging) is limited to one second, so that the
+  // multiplications below can't overflow. The animations skip the rest of
+  // the gap, and so does the scanner's shared time (see seek).
+  uint32_t elapsed = now - lastFrameTime;
+  lastFrameTime = now;
+#if CE3K_PROFILE
+  ce3kProfileFrame(elapsed);   // Check this scanner's frame against the deadline.
+#endif
+  if (elapsed > 1000)
+  {
+    epochMillis += elapsed - 1000;
+    elapsed = 1000;
+  }
+
+  // Cycle to the next scanner pattern at intervals. The new pattern starts
+  // scrolling from the moment of the change, which may be partway through
+  // this frame, so that the scroll position of each pattern is always its
+  // speed times the time since it started (see scrollPositionAt).
+  uint32_t scrollElapsed = elapsed;
+  patternElapsed += elapsed;
+  if (patternElapsed >= CE3K_PATTERN_CHANGE_INTERVAL)
+  {
+    patternElapsed -= CE3K_PATTERN_CHANGE_INTERVAL;
+    if (colorCyclingIsOn)   // This variable globally toggles animations on and off.
+    {
+      int nextPatternIndex = currentPatternIndex + 1;
+      if (nextPatternIndex >= NUM_CE3K_PATTERNS) { nextPatternIndex = 0; }
+#if CE3K_PATTERN_CROSSFADE > 0
+      crossfadeToPattern(nextPatternIndex);
+#else
+      scrollPosition = 0;   // Must reset this variable when changing patterns
+                            // in order to prevent positioning and indexing bugs.
+      activatePattern(nextPatternIndex);
+#endif
+      scrollElapsed = patternElapsed;
+    }
+  }
+
+  // Move the scroll position along by the time that has actually passed
+  // since the previous frame, rather than by a fixed step per frame, so that
+  // the bars keep moving at the same speed even when a frame runs late.
+  // Likewise, play as many frames of the conversation animation as have
+  // come due. First check the variable which globally toggles animations
+  // on and off.
+  if (colorCyclingIsOn)
+  {
+    scrollPosition += scrollSpeed * scrollElapsed;
+#if CE3K_PATTERN_CROSSFADE > 0
+    if (crossfading) { advanceCrossfade(elapsed); }
+#endif
+    conversationElapsed += elapsed;
+    while (conversationElapsed >= CONVERSATION_FLASH_SPEED)
+    {
+      stepConversation();
+      conversationElapsed -= CONVERSATION_FLASH_SPEED;
+    }
+  }
+
+  // Wrap the scroll position back around once the pattern has gone through
+  // a full cycle, where the view looks exactly the same as at the start.
+  // That way it never overflows and never makes a visible jump.
+  if (scrollPeriodRows > 0 && (scrollPosition >> 16) >= scrollPeriodRows)
+  {
+    scrollPosition %= (uint32_t)scrollPeriodRows << 16;
+  }
+
+  // The row of the image we're on is the whole-number part of the scroll
+  // position, and the blend weight between that row and the next one is
+  // the top 8 bits of the fractional part, from 0 to 255. That gives a
+  // smooth linear brightness transition between each line as the scroll
+  // position moves, using only integer math. The blend is based on:
+  // http://www.designimage.co.uk/quick-tip-the-maths-to-blend-between-two-values/
+  // While the scheduler is running at reduced quality, the fractional part
+  // is dropped, so the bars only move in whole rows.
+  uint32_t renderPosition = scrollPosition;
+  if (overloaded()) { renderPosition &= 0xFFFF0000; }
+  long    imageOffset = (long)(renderPosition >> 16) * currentPattern.Width;
+  uint8_t blendWeight = (renderPosition >> 8) & 0xFF;
+
+  // Note: The blend weight above gives a purely linear blend.
+  // Unfortunately the LEDs do not have a purely linear brightness based on
+  // the numbers pumped into them. The lowest brightness level of an LED is
+  // significantly brighter than when the LED is just "off". This used to make
+  // the antialiased pixels "pop" from fully dark to dimly-lit, and made the
+  // transition points between black background and the white bars seem to
+  // "caterpillar" across the strand. The blended slit is now run through the
+  // SCANNER_GAMMA lookup table, see assembleSlitRow() for details.
+
+  // Assemble the current slit view into the slit array, one whole row at a
+  // time. On a CRGBW strip I'm using only the White LED here, so the colored
+  // conversation lights can be painted separately without having to blend
+  // them with the white LEDs. On a CRGB strip, the white is stored as gray.
+  CE3K_STAGE_BEGIN(CE3K_STAGE_SLIT);
+#if CE3K_FRAME_CACHE_BYTES > 0
+  if (!readFrameCache(currentPattern, renderPosition))
+#endif
+  {
+    assembleSlitRow(currentPattern, imageOffset, blendWeight);
+  }
+#if CE3K_PATTERN_CROSSFADE > 0
+  if (crossfading) { crossfadeSlit(); }
+#endif
+  CE3K_STAGE_END(CE3K_STAGE_SLIT);
+
+  // Copy the slit array onto the entire LED strand. If the current width is
+  // less than the total number of LEDs, then it will copy it multiple times.
+  // If the current width is larger than the total number of LEDs, it will
+  // copy only the relevant subsection. More details and example found here:
+  // https://github.com/marmilicious/FastLED_examples/blob/master/memmove8_pattern_copy.ino
+
+  // This code has had some speed optimizations made. Originally it was an
+  // incrementing for/next loop, and in the middle of the loop there was
+  // an "if" test every time to determine if the copied data would exceed the
+  // end of the strand. Instead, here it has been changed to a descending
+  // while loop so that its test condition runs faster. Also the variables
+  // have been changed to uints instead of ints to make things faster. And
+  // the "if" test no longer runs every loop, instead it copies leftover
+  // pixels at the end of the strand when the loop is done. It knows whether
+  // there are leftover pixels to copy, because the costly division
+  // operations have been pre-calculated in the "activatePattern" routine,
+  // instead of being done every time through the loop.
+  CE3K_STAGE_BEGIN(CE3K_STAGE_COPY);
+  uint16_t patternWidth = slitWidth;
+
+  // Dirty-range tracking: if the slit view is exactly the same as the one
+  // already on the strand, for example while the animation is paused, then
+  // there's nothing to copy, and the frame hasn't changed.
+  bool slitChanged = (patternWidth != shownSlitWidth) ||
+                     (memcmp(&shownSlit[0], &zigzagSlit[0], patternWidth * sizeof(CE3KledPixel)) != 0);
+  if (slitChanged)
+  {
+    memmove8(&shownSlit[0], &zigzagSlit[0], patternWidth * sizeof(CE3KledPixel));
+    shownSlitWidth = patternWidth;
+    markDirty(0, numLeds - 1);
+
+#if CE3K_ZERO_COPY_OUTPUT
+    // Zero-copy output: just describe the copy, and leave it to the driver.
+    strandFrame.Slit      = &zigzagSlit[0];
+    strandFrame.Width     = patternWidth;
+    strandFrame.Repeats   = slitCopyFullRepeatsCount;
+    strandFrame.Remainder = slitCopyRemainingLeds;
+    strandFrame.NumPatches = 0;
+#else
+    uint16_t n = 0;
+    uint16_t copiedPatterns = slitCopyFullRepeatsCount;
+    while (copiedPatterns--)
+    {
+      // Copy the slit array to the LED strand. Syntax of this command is:    
+      // memmove8( &destination[start position], &source[start position], size of pixel data )      
+      // If you want to see just the color flashes and not the white scanner
+      // lights, either comment out the memmove8 lines, or set SCANNER_BRIGHTNESS 0.
+      memmove8(&leds[n], &zigzagSlit[0], patternWidth * sizeof(CE3KledPixel));
+      n += patternWidth;
+    }
+    if (slitCopyRemainingLeds > 0)
+    {
+      // Handle the final leftover slice (if the pattern doesn't divide evenly).
+      memmove8(&leds[n], &zigzagSlit[0], slitCopyRemainingLeds * sizeof(CE3KledPixel));
+    }
+#endif
+
+    // The copy has wiped out the color flashes, so they will need to be
+    // painted again from scratch.
+    numPaintedSpans = 0;
+
+#if CE3K_POWER_ESTIMATE
+    updateSlitPower(&zigzagSlit[0], patternWidth, slitCopyFullRepeatsCount, slitCopyRemainingLeds);
+    flashPower = 0;
+#endif
+  }
+  CE3K_STAGE_END(CE3K_STAGE_COPY);
+
+  // Check the variable which globally toggles animations on and off.
+  if (colorCyclingIsOn)
+  {
+    // Call the subroutine to paint the color conversation flashes onto this
+    // frame. If you wish to see only the scanner lines and not the color
+    // flashes, then comment out this line, or set CONVERSATION_BRIGHTNESS 0.
+    CE3K_STAGE_BEGIN(CE3K_STAGE_CONVERSATION);
+    paintConversation();
+    CE3K_STAGE_END(CE3K_STAGE_CONVERSATION);
+  }
+  else if (numPaintedSpans > 0)
+  {
+    // While the animations are off, the slit doesn't change, so the copy
+    // above is skipped and doesn't wipe out the color flashes. Erase them
+    // here instead, so that only the white scanner bars are left showing.
+    CE3K_STAGE_BEGIN(CE3K_STAGE_CONVERSATION);
+    eraseConversation();
+    CE3K_STAGE_END(CE3K_STAGE_CONVERSATION);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Shared time of the scanner at millis() "now": the number of milliseconds
+// since its pattern rotation started, when it was set up or, if it has been
+// sought since, since the time it was sought to. See CE3K_CONVERSATION_EPOCH.
+// ---------------------------------------------------------------------------
+uint32_t CE3Kscanner::sharedTime(uint32_t now)
+{
+  return now - epochMillis;
+}
+
+// ---------------------------------------------------------------------------
+// Jump straight to the state the scanner would be in at shared time "time",
+// had it been running since shared time 0, and make that the time at millis()
+// "now". Nothing in between is played: the pattern, the scroll position and
+// any crossfade are worked out directly from the time. The conversation is
+// played from the start of the current conversation epoch, or with
+// CE3K_CONVERSATION_EPOCH turned off, it starts over with no flashes, from a
+// seed worked out from the time (see CE3K_CONVERSATION_EPOCH). The
+// next call to update() draws the new state onto the strand, and the frames
+// after that stay on the beat of the shared time, so that scanners on
+// different controllers which have sought to the same time play the same
+// frames at the same moments. This assumes that the animations are turned
+// on (colorCyclingIsOn), and that scrollSpeed hasn't been changed from the
+// pattern's own speed.
+// ---------------------------------------------------------------------------
+void CE3Kscanner::seek(uint32_t time, uint32_t now)
+{
+  // Which pattern is running, and for how long it has been running.
+  uint32_t changes = time / CE3K_PATTERN_CHANGE_INTERVAL;
+  uint32_t elapsed = time % CE3K_PATTERN_CHANGE_INTERVAL;
+  int patternIndex = (firstPatternIndex + changes) % NUM_CE3K_PATTERNS;
+#if CE3K_PATTERN_CROSSFADE > 0
+  crossfading = false;
+  if (changes > 0 && elapsed < CE3K_PATTERN_CROSSFADE)
+  {
+    // Partway through a crossfade. The outgoing pattern has kept scrolling
+    // since the change, so start the crossfade from where it has got to.
+    activatePattern((patternIndex + NUM_CE3K_PATTERNS - 1) % NUM_CE3K_PATTERNS);
+    scrollPosition = scrollPositionAt(CE3K_PATTERN_CHANGE_INTERVAL + elapsed);
+    crossfadeToPattern(patternIndex);
+    crossfadeElapsed = elapsed;
+  }
+  else
+#endif
+  {
+    activatePattern(patternIndex);
+  }
+  patternElapsed = elapsed;
+  scrollPosition = scrollPositionAt(elapsed);
+
+  // The conversation, which starts over with no flashes running. With
+  // conversation epochs, it is played up to the time from the start of the
+  // current epoch. Without them, it carries on from here with a seed worked
+  // out from the time, rather than whatever this scanner's seed had got to.
+  conversationElapsed = time % CONVERSATION_FLASH_SPEED;
+  for (uint8_t f = 0; f < CONVERSATION_MAX_FLASHES; f++)
+  {
+    flashes[f] = CE3Kflash();
+  }
+  uint32_t steps = time / CONVERSATION_FLASH_SPEED;
+#if CE3K_CONVERSATION_EPOCH > 0
+  conversationStep = steps - (steps % CE3K_CONVERSATION_EPOCH_STEPS);
+  while (conversationStep < steps)
+  {
+    stepConversation();
+  }
+#else
+  randomSeed = ce3kEpochSeed(conversationSeed, steps);
+#endif
+
+  // Redraw the whole strand on the next frame, which is due now if "time" is
+  // on the beat, or else at the next beat.
+  shownSlitWidth = 0;
+  lateFrames     = 0;
+  onTimeFrames   = 0;
+  epochMillis    = now - time;
+  lastFrameTime  = now;
+  nextFrameTime  = now + ((SCANNER_ANIMATION_SPEED - (time % SCANNER_ANIMATION_SPEED)) % SCANNER_ANIMATION_SPEED);
+}
+
+// ---------------------------------------------------------------------------
+// Keep in step with a shared time received from another controller, which
+// was the shared time there at about millis() "now" here. If this scanner's
+// own shared time is more than CE3K_SYNC_TOLERANCE milliseconds away from it,
+// seek to it. Returns true if it did.
+// ---------------------------------------------------------------------------
+bool CE3Kscanner::syncTo(uint32_t time, uint32_t now)
+{
+  int32_t difference = (int32_t)(time - sharedTime(now));
+  if (difference >= -CE3K_SYNC_TOLERANCE && difference <= CE3K_SYNC_TOLERANCE) return false;
+  seek(time, now);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Update several scanners in one pass, for example a set of rings which are
+// each on their own part of the strand. All of them get the same reading of
+// millis(), so scanners which were set up together keep to the same frame
+// beat, and their frames all come due on the same call. Returns true if any
+// of them changed its part of the strand, in which case the strand needs
+// sending (and then each scanner's clearDirty() calling).
+// ---------------------------------------------------------------------------
+bool ce3kUpdateScanners(CE3Kscanner* scanners, uint8_t count)
+{
+  uint32_t now = millis();
+  bool changed = false;
+  for (uint8_t s = 0; s < count; s++)
+  {
+    scanners[s].update(now);
+    changed |= scanners[s].frameChanged;
+  }
+  return changed;
+}
+
+// ---------------------------------------------------------------------------
+// Sync messages, which one controller sends to the others to keep their
+// scanners in step (see CE3Kscanner::syncTo). A message is
+// CE3K_SYNC_MESSAGE_SIZE bytes, and can be sent over anything, such as a
+// serial link or a UDP broadcast:
+//
+//   Bytes 0-1   'C', 'E', to find the start of a message in a serial stream.
+//   Byte  2     Version of the message format, CE3K_SYNC_VERSION.
+//   Byte  3     Number of patterns in the pattern table, since controllers
+//               with different tables can't be in step.
+//   Bytes 4-7   The sender's shared time, least significant byte first.
+//   Bytes 8-9   Fletcher-16 checksum of bytes 0-7.
+//
+// The sender would send one every second or so, with
+// ce3kWriteSyncMessage(message, ce3kMainScanner.sharedTime(millis())), and
+// each receiver would pass the time it reads to syncTo(time, millis()).
+// ---------------------------------------------------------------------------
+#define CE3K_SYNC_MESSAGE_SIZE 10
+#define CE3K_SYNC_VERSION      1
+
+uint16_t ce3kSyncChecksum(const uint8_t* message)
+{
+  uint8_t sum1 = 0;
+  uint8_t sum2 = 0;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    sum1 = (sum1 + message[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return ((uint16_t)sum2 << 8) | sum1;
+}
+
+void ce3kWriteSyncMessage(uint8_t* message, uint32_t time)
+{
+  message[0] = 'C';
+  message[1] = 'E';
+  message[2] = CE3K_SYNC_VERSION;
+  message[3] = NUM_CE3K_PATTERNS;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    message[4 + i] = (uint8_t)(time >> (8 * i));
+  }
+  uint16_t checksum = ce3kSyncChecksum(message);
+  message[8] = (uint8_t)checksum;
+  message[9] = (uint8_t)(checksum >> 8);
+}
+
+// Read the shared time out of a sync message. Returns false, and leaves the
+// time alone, if the message is damaged or from an incompatible controller.
+bool ce3kReadSyncMessage(const uint8_t* message, uint32_t* time)
+{
+  uint16_t checksum = ce3kSyncChecksum(message);
+  if (message[0] != 'C' || message[1] != 'E' || message[2] != CE3K_SYNC_VERSION ||
+      message[3] != NUM_CE3K_PATTERNS || message[8] != (uint8_t)checksum || message[9] != (uint8_t)(checksum >> 8))
+  {
+    return false;
+  }
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    value |= (uint32_t)message[4 + i] << (8 * i);
+  }
+  *time = value;
+  return true;
+}
+
+#if CE3K_ZERO_COPY_OUTPUT
+// ---------------------------------------------------------------------------
+// Walk the zero-copy description of the strand from the first pixel to the
+// last, handing it to "sink" as a series of runs of pixels. The sink is any
+// function or object that can be called as sink(const CE3KledPixel* pixels,
+// uint16_t count), such as an LED driver which sends each run out of its data
+// pin. Unpatched runs point straight into the slit array, so nothing is
+// copied. Patched pixels are built in a small buffer, a few at a time, since
+// they need the patch color combined with the slit pixel underneath.
+// ---------------------------------------------------------------------------
+template <typename SINK>
+void ce3kStreamStrand(const CE3KstrandFrame& frame, SINK& sink)
+{
+  if (frame.Width == 0) return;
+  uint16_t total    = (frame.Repeats * frame.Width) + frame.Remainder;
+  uint16_t position = 0;
+  uint16_t column   = 0;
+  uint8_t  patchIndex = 0;
+
+  while (position < total)
+  {
+    // Send the slit as-is up to the start of the next patch, or the end of
+    // the strand if there are no more patches.
+    uint16_t runEnd = total;
+    if (patchIndex < frame.NumPatches && frame.Patches[patchIndex].Start < total)
+    {
+      runEnd = frame.Patches[patchIndex].Start;
+    }
+    while (position < runEnd)
+    {
+      uint16_t run = frame.Width - column;
+      if (run > runEnd - position) { run = runEnd - position; }
+      sink(&frame.Slit[column], run);
+      position += run;
+      column   += run;
+      if (column >= frame.Width) { column = 0; }
+    }
+    if (position >= total) break;
+
+    // Send the patch, limited to the end of the strand.
+    const CE3Kpatch& patch = frame.Patches[patchIndex++];
+    uint16_t patchEnd = patch.Start + patch.Count;
+    if (patchEnd > total) { patchEnd = total; }
+    CE3KledPixel patched[16];
+    while (position < patchEnd)
+    {
+      uint8_t batch = 0;
+      while (position < patchEnd && batch < 16)
+      {
+        CE3KledOps::paint(patched[batch], frame.Slit[column], patch.Color);
+        batch++;
+        position++;
+        if (++column >= frame.Width) { column = 0; }
+      }
+      sink(&patched[0], batch);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Expand the zero-copy description of the strand into a full LED array, for
+// LED drivers (such as the stock FastLED controllers) which can only send
+// from a full array. The result is the same as the normal, non-zero-copy path.
+// ---------------------------------------------------------------------------
+struct CE3KexpandSink
+{
+  CE3KledPixel* Destination;
+  void operator()(const CE3KledPixel* pixels, uint16_t count)
+  {
+    memmove8(Destination, pixels, count * sizeof(CE3KledPixel));
+    Destination += count;
+  }
+};
+
+void CE3Kscanner::expandStrand(CE3KledPixel* destination)
+{
+  CE3KexpandSink sink = { destination };
+  ce3kStreamStrand(strandFrame, sink);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// The single scanner which the sketch in this folder runs over the whole of
+// leds[], and the functions and variables which the sketch uses to run it.
+// These are the same names that the scanner has always had, from before there
+// could be more than one scanner, so older sketches keep working unchanged.
+// ---------------------------------------------------------------------------
+CE3Kscanner ce3kMainScanner;
+
+bool&     ce3kFrameChanged = ce3kMainScanner.frameChanged;  // See CE3Kscanner::frameChanged.
+uint16_t& ce3kDirtyMin     = ce3kMainScanner.dirtyMin;
+uint16_t& ce3kDirtyMax     = ce3kMainScanner.dirtyMax;
+uint32_t& ce3kScrollSpeed  = ce3kMainScanner.scrollSpeed;   // See CE3Kscanner::scrollSpeed.
+#if CE3K_ZERO_COPY_OUTPUT
+CE3KstrandFrame& ce3kStrandFrame = ce3kMainScanner.strandFrame;
+#endif
+
+// One-time setup of the CE3K scanner effect. Call this once from the
+// "setup()" of the main Arduino code, before the first call to ce3kScanner().
+void ce3kSetup()
+{
+  ce3kMainScanner.setup(leds, NUM_LEDS);
+}
+
+// Main loop of the CE3K scanner effect. This routine should be called once
+// per "loop()" of the main Arduino code, see CE3Kscanner::update().
+void ce3kScanner()
+{
+  ce3kMainScanner.update(millis());
+}
+
+void ce3kClearDirty()
+{
+  ce3kMainScanner.clearDirty();
+}
+
+#if CE3K_POWER_ESTIMATE
+uint32_t ce3kPowerMilliwatts()
+{
+  return ce3kMainScanner.powerMilliwatts();
+}
+
+uint8_t ce3kPowerBrightness(uint8_t targetBrightness, uint32_t maxMilliwatts)
+{
+  return ce3kMainScanner.powerBrightness(targetBrightness, maxMilliwatts);
+}
+#endif
+
+#if CE3K_ZERO_COPY_OUTPUT
+void ce3kExpandStrand(CE3KledPixel* destination)
+{
+  ce3kMainScanner.expandStrand(destination);
+}
+#endif
+
+// Print the frame cache report of the main scanner, if one is due (see
+// CE3K_FRAME_CACHE_REPORT). Call this from loop() in between frames.
+#if CE3K_FRAME_CACHE_BYTES > 0 && CE3K_FRAME_CACHE_REPORT
+void ce3kFrameCacheReport()
+{
+  ce3kMainScanner.reportFrameCache();
+}
+#else
+inline void ce3kFrameCacheReport() {}
+#endif
+
 #endif
\ No newline at end of file
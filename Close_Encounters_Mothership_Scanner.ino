@@ -19,13 +19,12 @@
 //   https://www.amazon.com/dp/B0046AMGW0
 //   https://www.amazon.com/dp/B07TGF9VMQ
 //
-// Special note: This code is intended for use with CRGBW LED strips. Note
-// the "W" at the end of the "CRGBW". This means that the strips have red,
-// green, and blue LEDS, but also include a white LED too. I am using "BTF"
-// brand SK6812 RGBW strips (https://www.amazon.com/dp/B079ZW1265), but any
-// brand will work. I'm deliberately taking advantage of the separation of RGB
-// from W in my code, but it should be relatively simple to refactor this code
-// to work with regular CRGB strips, if that's what you're using.
+// Special note: This code was written for CRGBW LED strips. Note the "W" at
+// the end of the "CRGBW". This means that the strips have red, green, and blue
+// LEDS, but also include a white LED too. I am using "BTF" brand SK6812 RGBW
+// strips (https://www.amazon.com/dp/B079ZW1265), but any brand will work. I'm
+// deliberately taking advantage of the separation of RGB from W in my code.
+// If you have regular CRGB strips instead, set LED_STRIP_IS_RGBW to 0 below.
 // ---------------------------------------------------------------------------
 
 // Include LED header files.
@@ -40,6 +39,7 @@
 #define MAX_POWER_MILLIAMPS     500    // Set to appropriate power for your LED power supply.
 #define SERIAL_PORT_SPEED       115200
 #define BRIGHTNESS              255
+#define LED_STRIP_IS_RGBW       1      // Set to 0 for regular RGB strips without the white LED.
 
 // This variable can be modified to globally toggle animations off and on.
 // On my particular system, there is a button combo on the lighting
@@ -50,8 +50,14 @@ bool colorCyclingIsOn = true;
 // definitions, which is needed for the special CRGBW strips with the extra
 // white LED. See this web site for more details about coding for CRGBW:
 // https://www.partsnotincluded.com/fastled-rgbw-neopixels-sk6812/
+// The effect code looks at the type of the "leds" array to decide whether to
+// blend the white scanner bars into the RGB values of a regular CRGB strip.
+#if LED_STRIP_IS_RGBW
 CRGBW leds[NUM_LEDS];
 CRGB *ledsRGB = (CRGB *) &leds[0];
+#else
+CRGB leds[NUM_LEDS];
+#endif
 
 // Main code for the animations, file is in the same folder as this one.
 #include "Close_Encounters_Mothership_Scanner.h"
@@ -64,9 +70,19 @@ void setup()
 
   // Initialize FastLED, modified for use with RGBW light strips - Details at
   // https://www.partsnotincluded.com/fastled-rgbw-neopixels-sk6812/
+#if LED_STRIP_IS_RGBW
   FastLED.addLeds<LED_TYPE, DATA_PIN, COLOR_ORDER>(ledsRGB, getRGBWsize(NUM_LEDS));
-  FastLED.setMaxPowerInVoltsAndMilliamps( 5, MAX_POWER_MILLIAMPS);
+#else
+  FastLED.addLeds<LED_TYPE, DATA_PIN, COLOR_ORDER>(leds, NUM_LEDS);
+#endif
   FastLED.setBrightness(BRIGHTNESS);
+#if !CE3K_POWER_ESTIMATE
+  FastLED.setMaxPowerInVoltsAndMilliamps( 5, MAX_POWER_MILLIAMPS);
+#endif
+
+  // One-time setup of the effect located in the included file
+  // "Close_Encounters_Mothership_Scanner.h"
+  ce3kSetup();
 }
 
 // Arduino main loop, runs continuously after the setup routine is done.
@@ -76,7 +92,37 @@ void loop()
   // located in the included file "Close_Encounters_Mothership_Scanner.h"
   ce3kScanner();
 
-  // Paint the final LED array values onto the LED strip for this frame.
-  FastLED.show();
+  // Most loops happen in between the frames of the animations, and don't
+  // change anything. Only send the LED array to the strip when it changed.
+  if (ce3kFrameChanged)
+  {
+    CE3K_STAGE_BEGIN(CE3K_STAGE_SHOW);
+#if CE3K_ZERO_COPY_OUTPUT
+    // The stock FastLED controllers can't walk the zero-copy description of the
+    // strand, so fill in the LED array from it before showing it.
+    ce3kExpandStrand(leds);
+#endif
+
+#if CE3K_POWER_ESTIMATE
+    // Limit the brightness of this frame to what the power supply can handle,
+    // with the power estimate from the effect code, which is much quicker
+    // than FastLED.setMaxPowerInVoltsAndMilliamps() on a long strand, and
+    // counts the white LEDs properly.
+    FastLED.setBrightness(ce3kPowerBrightness(BRIGHTNESS, 5 * MAX_POWER_MILLIAMPS));
+#endif
+
+    // Paint the final LED array values onto the LED strip for this frame.
+    FastLED.show();
+    CE3K_STAGE_END(CE3K_STAGE_SHOW);
+    ce3kClearDirty();
+  }
+  else
+  {
+    // Print the profiler statistics, if CE3K_PROFILE is turned on, and the
+    // frame cache statistics, if CE3K_FRAME_CACHE_REPORT is turned on, in
+    // between frames where they won't hold up the animation.
+    ce3kProfileReport();
+    ce3kFrameCacheReport();
+  }
 }
 
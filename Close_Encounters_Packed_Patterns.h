@@ -0,0 +1,311 @@
+// ---------------------------------------------------------------------------
+// Close_Encounters_Packed_Patterns.h
+//
+// Bit-packed (CE3K_FORMAT_PACKED) and run-length (CE3K_FORMAT_RLE) versions
+// of the pattern arrays defined in Close_Encounters_Mothership_Scanner.h. This
+// file is generated by the program extras/host/Pack_Patterns.cpp; do not edit
+// it by hand. See the CE3K_FORMAT values for the layout of each format. The
+// Size values are in pixels, not bytes, to match the byte arrays.
+//
+// This file has no include guard of its own; it is included only from inside
+// the include guard of Close_Encounters_Mothership_Scanner.h.
+// ---------------------------------------------------------------------------
+
+const uint32_t PROGMEM arrayTony01Packed[] = 
+{
+  0xFFFFFF80, 0x0000000F,
+  0xFFFFFF00, 0x00000807,
+  0xFFFFFE01, 0x00000C03,
+  0xFFFFFC03, 0x00000E01,
+  0xFFFFF807, 0x00000F00,
+  0x7FFFF00F, 0x00000F80,
+  0x3FFFE01F, 0x00000FC0,
+  0x1FFFC03F, 0x00000FE0,
+  0x0FFF807F, 0x00000FF0,
+  0x07FF00FF, 0x00000FF8,
+  0x03FE01FF, 0x00000FFC,
+  0x01FC03FF, 0x00000FFE,
+  0x00F807FF, 0x00000FFF,
+  0x80700FFF, 0x00000FFF,
+  0xC0201FFF, 0x00000FFF,
+  0xE0003FFF, 0x00000FFF,
+  0xF0007FFF, 0x00000FFF,
+  0xF800FFFF, 0x00000FFF,
+  0xFC01FFFF, 0x00000FFF,
+  0xFE03FFFF, 0x00000FFF,
+  0xFF07FFFF, 0x00000FFF,
+  0xFF8FFFFF, 0x00000FFF,
+  0xFFDFFFFF, 0x00000FFF,
+};
+const int arrayTony01PackedSize = 1012;
+const int arrayTony01PackedWidth = 44;
+
+const uint8_t PROGMEM arrayTony01Rle[] = 
+{
+  // Row index.
+  0x2E,0x00, 0x31,0x00, 0x35,0x00, 0x3B,0x00, 0x41,0x00, 0x47,0x00, 0x4D,0x00, 0x53,0x00,
+  0x59,0x00, 0x5F,0x00, 0x65,0x00, 0x6B,0x00, 0x71,0x00, 0x77,0x00, 0x7D,0x00, 0x83,0x00,
+  0x87,0x00, 0x8B,0x00, 0x8F,0x00, 0x93,0x00, 0x97,0x00, 0x9B,0x00, 0x9F,0x00,
+  // Runs of each row, dark first.
+  7,29,8,
+  8,27,8,1,
+  0,1,8,25,8,2,
+  0,2,8,23,8,3,
+  0,3,8,21,8,4,
+  0,4,8,19,8,5,
+  0,5,8,17,8,6,
+  0,6,8,15,8,7,
+  0,7,8,13,8,8,
+  0,8,8,11,8,9,
+  0,9,8,9,8,10,
+  0,10,8,7,8,11,
+  0,11,8,5,8,12,
+  0,12,8,3,8,13,
+  0,13,8,1,8,14,
+  0,14,15,15,
+  0,15,13,16,
+  0,16,11,17,
+  0,17,9,18,
+  0,18,7,19,
+  0,19,5,20,
+  0,20,3,21,
+  0,21,1,22,
+};
+const int arrayTony01RleSize = 1012;
+const int arrayTony01RleWidth = 44;
+
+const uint32_t PROGMEM arrayTony02Packed[] = 
+{
+  0xFFF80FFF, 0x00000E03,
+  0xFFFC07FF, 0x00000F01,
+  0xFFFE03FF, 0x00000F80,
+  0x7FFF01FF, 0x00000FC0,
+  0x3FFF80FF, 0x00000FE0,
+  0x1FFFC07F, 0x00000FF0,
+  0x0FFFE03F, 0x00000FF8,
+  0x07FFF01F, 0x00000FFC,
+  0x03FFF80F, 0x00000FFE,
+  0x01FFFC07, 0x00000FFF,
+  0x80FFFE03, 0x00000FFF,
+  0xC07FFF01, 0x00000FFF,
+  0xE03FFF80, 0x00000FFF,
+  0xF01FFFC0, 0x000007FF,
+  0xF80FFFE0, 0x000003FF,
+  0xFC07FFF0, 0x000001FF,
+  0xFE03FFF8, 0x000000FF,
+  0xFF01FFFC, 0x0000007F,
+  0xFF80FFFE, 0x0000003F,
+  0xFFC07FFF, 0x0000001F,
+  0xFFE03FFF, 0x0000080F,
+  0xFFF01FFF, 0x00000C07,
+};
+const int arrayTony02PackedSize = 968;
+const int arrayTony02PackedWidth = 44;
+
+const uint8_t PROGMEM arrayTony02Rle[] = 
+{
+  // Row index.
+  0x2C,0x00, 0x32,0x00, 0x38,0x00, 0x3E,0x00, 0x44,0x00, 0x4A,0x00, 0x50,0x00, 0x56,0x00,
+  0x5C,0x00, 0x62,0x00, 0x68,0x00, 0x6E,0x00, 0x74,0x00, 0x78,0x00, 0x7D,0x00, 0x82,0x00,
+  0x87,0x00, 0x8C,0x00, 0x91,0x00, 0x96,0x00, 0x9B,0x00, 0xA1,0x00,
+  // Runs of each row, dark first.
+  0,12,7,15,7,3,
+  0,11,7,15,7,4,
+  0,10,7,15,7,5,
+  0,9,7,15,7,6,
+  0,8,7,15,7,7,
+  0,7,7,15,7,8,
+  0,6,7,15,7,9,
+  0,5,7,15,7,10,
+  0,4,7,15,7,11,
+  0,3,7,15,7,12,
+  0,2,7,15,7,13,
+  0,1,7,15,7,14,
+  7,15,7,15,
+  6,15,7,15,1,
+  5,15,7,15,2,
+  4,15,7,15,3,
+  3,15,7,15,4,
+  2,15,7,15,5,
+  1,15,7,15,6,
+  0,15,7,15,7,
+  0,14,7,15,7,1,
+  0,13,7,15,7,2,
+};
+const int arrayTony02RleSize = 968;
+const int arrayTony02RleWidth = 44;
+
+const uint32_t PROGMEM arrayTony03Packed[] = 
+{
+  0x0007E1F8,
+  0x0003F3F0,
+  0x0001FFE1,
+  0x0000FFC3,
+  0x00087F87,
+  0x000C3F0F,
+  0x000E1E1F,
+  0x000F0C3F,
+  0x000F807E,
+  0x000FC0FC,
+};
+const int arrayTony03PackedSize = 200;
+const int arrayTony03PackedWidth = 20;
+
+const uint8_t PROGMEM arrayTony03Rle[] = 
+{
+  // Row index.
+  0x14,0x00, 0x19,0x00, 0x1E,0x00, 0x23,0x00, 0x28,0x00, 0x2E,0x00, 0x34,0x00, 0x3A,0x00,
+  0x40,0x00, 0x44,0x00,
+  // Runs of each row, dark first.
+  3,6,4,6,1,
+  4,6,2,6,2,
+  0,1,4,12,3,
+  0,2,4,10,4,
+  0,3,4,8,4,1,
+  0,4,4,6,4,2,
+  0,5,4,4,4,3,
+  0,6,4,2,4,4,
+  1,6,8,5,
+  2,6,6,6,
+};
+const int arrayTony03RleSize = 200;
+const int arrayTony03RleWidth = 20;
+
+const uint32_t PROGMEM arrayTony04Packed[] = 
+{
+  0x0007E1F8,
+  0x0003F0FC,
+  0x0001F87E,
+  0x0000FC3F,
+  0x00087E1F,
+  0x000C3F0F,
+  0x000E1F87,
+  0x000F0FC3,
+  0x000F87E1,
+  0x000FC3F0,
+  0x0007E1F8,
+  0x000FC3F0,
+  0x000F87E1,
+  0x000F0FC3,
+  0x000E1F87,
+  0x000C3F0F,
+  0x00087E1F,
+  0x0000FC3F,
+  0x0001F87E,
+  0x0003F0FC,
+  0x0007E1F8,
+  0x000FC3F0,
+};
+const int arrayTony04PackedSize = 440;
+const int arrayTony04PackedWidth = 20;
+
+const uint8_t PROGMEM arrayTony04Rle[] = 
+{
+  // Row index.
+  0x2C,0x00, 0x31,0x00, 0x36,0x00, 0x3B,0x00, 0x40,0x00, 0x46,0x00, 0x4C,0x00, 0x52,0x00,
+  0x58,0x00, 0x5E,0x00, 0x62,0x00, 0x67,0x00, 0x6B,0x00, 0x71,0x00, 0x77,0x00, 0x7D,0x00,
+  0x83,0x00, 0x89,0x00, 0x8E,0x00, 0x93,0x00, 0x98,0x00, 0x9D,0x00,
+  // Runs of each row, dark first.
+  3,6,4,6,1,
+  2,6,4,6,2,
+  1,6,4,6,3,
+  0,6,4,6,4,
+  0,5,4,6,4,1,
+  0,4,4,6,4,2,
+  0,3,4,6,4,3,
+  0,2,4,6,4,4,
+  0,1,4,6,4,5,
+  4,6,4,6,
+  3,6,4,6,1,
+  4,6,4,6,
+  0,1,4,6,4,5,
+  0,2,4,6,4,4,
+  0,3,4,6,4,3,
+  0,4,4,6,4,2,
+  0,5,4,6,4,1,
+  0,6,4,6,4,
+  1,6,4,6,3,
+  2,6,4,6,2,
+  3,6,4,6,1,
+  4,6,4,6,
+};
+const int arrayTony04RleSize = 440;
+const int arrayTony04RleWidth = 20;
+
+const uint32_t PROGMEM arrayConversationPairsPacked[] = 
+{
+  0x000FE000,
+  0x001FF000,
+  0x003FF800,
+  0x007EFC00,
+  0x00FC7E00,
+  0x01F83F00,
+  0x03F01F80,
+  0x07E00FC0,
+  0x0FC007E0,
+  0x1F8003F0,
+  0x3F0001F8,
+  0x7E0000FC,
+  0xFC00007E,
+  0xF800003F,
+  0xF000001F,
+  0xE000000F,
+  0xF000001F,
+  0xF800003F,
+  0xFC00007E,
+  0x7E0000FC,
+  0x3F0001F8,
+  0x1F8003F0,
+  0x0FC007E0,
+  0x07E00FC0,
+  0x03F01F80,
+  0x01F83F00,
+  0x00FC7E00,
+  0x007EFC00,
+  0x003FF800,
+  0x001FF000,
+};
+const int arrayConversationPairsPackedSize = 960;
+const int arrayConversationPairsPackedWidth = 32;
+
+const uint8_t PROGMEM arrayConversationPairsRle[] = 
+{
+  // Row index.
+  0x3C,0x00, 0x3F,0x00, 0x42,0x00, 0x45,0x00, 0x4A,0x00, 0x4F,0x00, 0x54,0x00, 0x59,0x00,
+  0x5E,0x00, 0x63,0x00, 0x68,0x00, 0x6D,0x00, 0x72,0x00, 0x76,0x00, 0x7A,0x00, 0x7E,0x00,
+  0x82,0x00, 0x86,0x00, 0x8A,0x00, 0x8E,0x00, 0x93,0x00, 0x98,0x00, 0x9D,0x00, 0xA2,0x00,
+  0xA7,0x00, 0xAC,0x00, 0xB1,0x00, 0xB6,0x00, 0xBB,0x00, 0xBE,0x00,
+  // Runs of each row, dark first.
+  13,7,12,
+  12,9,11,
+  11,11,10,
+  10,6,1,6,9,
+  9,6,3,6,8,
+  8,6,5,6,7,
+  7,6,7,6,6,
+  6,6,9,6,5,
+  5,6,11,6,4,
+  4,6,13,6,3,
+  3,6,15,6,2,
+  2,6,17,6,1,
+  1,6,19,6,
+  0,6,21,5,
+  0,5,23,4,
+  0,4,25,3,
+  0,5,23,4,
+  0,6,21,5,
+  1,6,19,6,
+  2,6,17,6,1,
+  3,6,15,6,2,
+  4,6,13,6,3,
+  5,6,11,6,4,
+  6,6,9,6,5,
+  7,6,7,6,6,
+  8,6,5,6,7,
+  9,6,3,6,8,
+  10,6,1,6,9,
+  11,11,10,
+  12,9,11,
+};
+const int arrayConversationPairsRleSize = 960;
+const int arrayConversationPairsRleWidth = 32;
@@ -0,0 +1,218 @@
+// ---------------------------------------------------------------------------
+// Close_Encounters_Profiler.h
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Optional built-in profiler for the Close Encounters Mothership Scanner.
+// This file is only included when CE3K_PROFILE is turned on; see the notes
+// next to that setting in "Close_Encounters_Mothership_Scanner.h".
+//
+// It fills in the CE3K_STAGE_BEGIN/CE3K_STAGE_END timing hooks. Each time a
+// stage ends, the time it took is stored in a small ring buffer for that
+// stage, and added to the running minimum, maximum and total for that stage.
+// The gap between each scanner frame and the previous frame of the same
+// scanner is also checked against the SCANNER_ANIMATION_SPEED deadline, so
+// several scanners run one after another by ce3kUpdateScanners() are each
+// checked against their own frames. None of that allocates any memory or
+// prints anything. The statistics are only printed by ce3kProfileReport(),
+// which the sketch calls from loop() in between frames, and which prints at
+// most one short line per call, so that it never fills up the serial port's
+// transmit buffer and holds up the next frame.
+//
+// Every CE3K_PROFILE_INTERVAL milliseconds, the report is a series of CSV
+// lines, one per stage and then one for the frame deadlines:
+//
+//   CE3K profile,<stage>,<count>,<min>,<avg>,<max>,<p99>
+//   CE3K profile,deadline,<frames>,<missed>,<worst>
+//
+// Times are in ticks of CE3K_PROFILE_CLOCK(), which is micros() unless it
+// has been defined to something else before including the scanner code (for
+// example a CPU cycle counter, on processors which have one). The count, min,
+// avg and max cover every time the stage ran since the previous report. The
+// p99 is the 99th percentile of the most recent CE3K_PROFILE_SAMPLES times,
+// which are the ones still in the ring buffer. "missed" is the number of
+// frames which started more than a millisecond later than the
+// SCANNER_ANIMATION_SPEED deadline (allowing for the jitter of millis()), and
+// "worst" is the longest gap between frames, in milliseconds. With several
+// scanners, the statistics are of all of them together.
+//
+// The statistics are plain variables shared by every scanner, with no locks,
+// so the profiler can only be used where the scanners all run on the same
+// processor core, one after another, as they do on the Arduino.
+// ---------------------------------------------------------------------------
+#ifndef Close_Encounters_Profiler_h
+#define Close_Encounters_Profiler_h
+
+#if defined(CE3K_STAGE_BEGIN) || defined(CE3K_STAGE_END)
+  #error "CE3K_PROFILE uses the CE3K_STAGE_BEGIN/CE3K_STAGE_END hooks, which have already been defined elsewhere."
+#endif
+
+// Milliseconds between reports, and the number of recent times per stage that
+// are kept for the p99. Each kept time takes two bytes of RAM per stage.
+#ifndef CE3K_PROFILE_INTERVAL
+#define CE3K_PROFILE_INTERVAL    10000
+#endif
+#ifndef CE3K_PROFILE_SAMPLES
+#define CE3K_PROFILE_SAMPLES     64
+#endif
+#ifndef CE3K_PROFILE_CLOCK
+#define CE3K_PROFILE_CLOCK()     micros()
+#endif
+
+static_assert(CE3K_PROFILE_SAMPLES > 0 && CE3K_PROFILE_SAMPLES <= 255, "CE3K Scanner: CE3K_PROFILE_SAMPLES must be from 1 to 255.");
+
+// Statistics for one stage. The times are stored as 16 bits to save RAM; a
+// stage which takes longer than that is recorded as 65535.
+typedef struct
+{
+  uint32_t Start;                           // Clock reading when the stage began.
+  uint32_t Count;                           // Times the stage ran since the last report.
+  uint32_t Total;                           // Sum of those times, for the average.
+  uint16_t Min;
+  uint16_t Max;
+  uint16_t Samples[CE3K_PROFILE_SAMPLES];   // Ring buffer of the most recent times.
+  uint8_t  NextSample;                      // Where the next time goes in the ring buffer.
+  uint8_t  NumSamples;                      // How much of the ring buffer is filled in.
+} CE3KprofileStage;
+
+CE3KprofileStage ce3kProfileStages[CE3K_NUM_STAGES];
+
+// Frame deadline statistics since the last report.
+uint16_t ce3kProfileFrames     = 0;
+uint16_t ce3kProfileMissed     = 0;
+uint16_t ce3kProfileWorstGap   = 0;
+
+// Scratch space for sorting the ring buffer when working out the p99, so
+// that the report doesn't need to allocate any memory.
+uint16_t ce3kProfileSorted[CE3K_PROFILE_SAMPLES];
+
+// Which line of the report is printed next, or 0 if no report is in progress,
+// and when the last report was started.
+uint8_t  ce3kProfileReportLine = 0;
+uint32_t ce3kProfileLastReport = 0;
+
+// ---------------------------------------------------------------------------
+// Timing hooks, called at the start and end of each stage of a frame.
+// ---------------------------------------------------------------------------
+inline void ce3kProfileBegin(uint8_t stage)
+{
+  ce3kProfileStages[stage].Start = CE3K_PROFILE_CLOCK();
+}
+
+inline void ce3kProfileEnd(uint8_t stage)
+{
+  CE3KprofileStage& s = ce3kProfileStages[stage];
+  uint32_t ticks = (uint32_t)CE3K_PROFILE_CLOCK() - s.Start;
+  uint16_t sample = (ticks > 0xFFFF) ? 0xFFFF : ticks;
+
+  if (s.Count == 0 || sample < s.Min) { s.Min = sample; }
+  if (s.Count == 0 || sample > s.Max) { s.Max = sample; }
+  s.Count++;
+  s.Total += sample;
+
+  s.Samples[s.NextSample] = sample;
+  if (++s.NextSample >= CE3K_PROFILE_SAMPLES) { s.NextSample = 0; }
+  if (s.NumSamples < CE3K_PROFILE_SAMPLES)    { s.NumSamples++; }
+}
+
+#define CE3K_STAGE_BEGIN(stage) ce3kProfileBegin(stage)
+#define CE3K_STAGE_END(stage)   ce3kProfileEnd(stage)
+
+// ---------------------------------------------------------------------------
+// Deadline check, called by each scanner at the start of each of its frames,
+// with the milliseconds since its own previous frame.
+// ---------------------------------------------------------------------------
+inline void ce3kProfileFrame(uint32_t gap)
+{
+  if (gap > 0xFFFF) { gap = 0xFFFF; }
+  if (gap > SCANNER_ANIMATION_SPEED + 1) { ce3kProfileMissed++; }
+  if (gap > ce3kProfileWorstGap) { ce3kProfileWorstGap = gap; }
+  ce3kProfileFrames++;
+}
+
+// ---------------------------------------------------------------------------
+// Work out the 99th percentile of the times in a stage's ring buffer, by
+// sorting a copy of them. This is only done while printing a report.
+// ---------------------------------------------------------------------------
+uint16_t ce3kProfilePercentile99(const CE3KprofileStage& s)
+{
+  uint8_t n = s.NumSamples;
+  if (n == 0) return 0;
+
+  // Insertion sort, which is plenty fast enough for a few dozen numbers.
+  for (uint8_t i = 0; i < n; i++)
+  {
+    uint16_t value = s.Samples[i];
+    uint8_t  j = i;
+    while (j > 0 && ce3kProfileSorted[j - 1] > value)
+    {
+      ce3kProfileSorted[j] = ce3kProfileSorted[j - 1];
+      j--;
+    }
+    ce3kProfileSorted[j] = value;
+  }
+
+  // The smallest time which at least 99% of the times are no larger than.
+  uint16_t rank = ((uint16_t)n * 99 + 99) / 100;
+  return ce3kProfileSorted[rank - 1];
+}
+
+// ---------------------------------------------------------------------------
+// Print the profiler's statistics to the serial port. Call this from loop(),
+// in between frames rather than in the middle of one. Every
+// CE3K_PROFILE_INTERVAL milliseconds it starts a new report, and then prints
+// one line of it on each call until the report is finished.
+// ---------------------------------------------------------------------------
+void ce3kProfileReport()
+{
+  if (ce3kProfileReportLine == 0)
+  {
+    if (millis() - ce3kProfileLastReport < CE3K_PROFILE_INTERVAL) return;
+    ce3kProfileLastReport = millis();
+    ce3kProfileReportLine = 1;
+  }
+
+  uint8_t line = ce3kProfileReportLine - 1;
+  Serial.print(F("CE3K profile,"));
+  if (line < CE3K_NUM_STAGES)
+  {
+    // One line per stage, after which that stage's statistics start over.
+    CE3KprofileStage& s = ce3kProfileStages[line];
+    switch (line)
+    {
+      case CE3K_STAGE_SLIT:         Serial.print(F("slit"));         break;
+      case CE3K_STAGE_COPY:         Serial.print(F("copy"));         break;
+      case CE3K_STAGE_CONVERSATION: Serial.print(F("conversation")); break;
+      case CE3K_STAGE_SHOW:         Serial.print(F("show"));         break;
+    }
+    Serial.print(',');
+    Serial.print(s.Count);
+    Serial.print(',');
+    Serial.print(s.Count ? s.Min : 0);
+    Serial.print(',');
+    Serial.print(s.Count ? s.Total / s.Count : 0);
+    Serial.print(',');
+    Serial.print(s.Count ? s.Max : 0);
+    Serial.print(',');
+    Serial.println(ce3kProfilePercentile99(s));
+    s.Count = 0;
+    s.Total = 0;
+    ce3kProfileReportLine++;
+  }
+  else
+  {
+    // Then the frame deadlines, and the report is finished.
+    Serial.print(F("deadline,"));
+    Serial.print(ce3kProfileFrames);
+    Serial.print(',');
+    Serial.print(ce3kProfileMissed);
+    Serial.print(',');
+    Serial.println(ce3kProfileWorstGap);
+    ce3kProfileFrames     = 0;
+    ce3kProfileMissed     = 0;
+    ce3kProfileWorstGap   = 0;
+    ce3kProfileReportLine = 0;
+  }
+}
+
+#endif
@@ -14,6 +14,70 @@
 #ifndef FastLED_RGBW_h
 #define FastLED_RGBW_h
 
+// ----------------------------------------------------------------------------
+// Whole-pixel math. A CRGBW pixel is exactly four bytes, so on processors with
+// 32-bit registers, the helpers below (all but blur1d, see there) work on all
+// four channels of a pixel at once, as a single uint32_t ("SIMD within a register"). Scaling splits the
+// pixel into two pairs of channels, each in its own 16-bit lane, so that one
+// multiply scales two channels without them spilling into each other, and
+// saturating adds detect the carry out of each byte and turn it into 0xFF.
+// Where the compiler has been told it can use AVX2 (PC) or NEON (ARM), the
+// helpers which work on a whole strand use those instructions, for 8 or 4
+// pixels at a time. Every version gives exactly the same results as scale8()
+// and qadd8() on each channel. On the 8-bit AVR processors, 32-bit math is
+// slower than doing one byte at a time, so the original code is used there.
+// Define RGBW_SWAR_OFF before including this file to always use it.
+// ----------------------------------------------------------------------------
+#if !defined(__AVR__) && !defined(RGBW_SWAR_OFF)
+  #define RGBW_SWAR
+  #if defined(__AVX2__)
+    #include <immintrin.h>
+    #define RGBW_SWAR_AVX2
+    #define RGBW_SWAR_KERNEL "32-bit words, AVX2"
+  #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define RGBW_SWAR_NEON
+    #define RGBW_SWAR_KERNEL "32-bit words, NEON"
+  #else
+    #define RGBW_SWAR_KERNEL "32-bit words"
+  #endif
+#else
+  #define RGBW_SWAR_KERNEL "one channel at a time"
+#endif
+
+#ifdef RGBW_SWAR
+// scale8() multiplies by (scale + 1) when FASTLED_SCALE8_FIXED is on, and by
+// scale when it is off.
+#if (FASTLED_SCALE8_FIXED == 1)
+  #define RGBW_SCALE8_FIXED_ADD 1
+#else
+  #define RGBW_SCALE8_FIXED_ADD 0
+#endif
+
+// Scale all four channels of a pixel word, the same as scale8() on each.
+LIB8STATIC uint32_t rgbwScale8(uint32_t pixel, fract8 scale)
+{
+  uint32_t multiplier = (uint32_t)scale + RGBW_SCALE8_FIXED_ADD;
+  uint32_t evenBytes  = ((pixel & 0x00FF00FF) * multiplier) >> 8;
+  uint32_t oddBytes   = ((pixel >> 8) & 0x00FF00FF) * multiplier;
+  return (evenBytes & 0x00FF00FF) | (oddBytes & 0xFF00FF00);
+}
+
+// Add all four channels of two pixel words, the same as qadd8() on each.
+LIB8STATIC uint32_t rgbwQadd8(uint32_t a, uint32_t b)
+{
+  // Add the low seven bits of each byte, then put the top bits back in
+  // without letting them carry into the next byte.
+  uint32_t sum   = (a & 0x7F7F7F7F) + (b & 0x7F7F7F7F);
+  sum ^= (a ^ b) & 0x80808080;
+
+  // A byte overflowed if both top bits were set, or if either was set and
+  // the sum's top bit is clear. Those bytes become 0xFF.
+  uint32_t carry = ((a & b) | ((a | b) & ~sum)) & 0x80808080;
+  return sum | ((carry >> 7) * 0xFF);
+}
+#endif
+
 
 LIB8STATIC void nscale8x4( uint8_t& r, uint8_t& g, uint8_t& b, uint8_t& w, fract8 scale)
 {
@@ -65,6 +129,10 @@ struct CRGBW
 		r = rd;	g = grn; b = blu;	w = wht;
 	}
 
+  // Copying a whole pixel. This has to be declared, because the assignment
+  // below is, or newer compilers warn about every copy (-Wdeprecated-copy).
+	inline CRGBW(const CRGBW&) = default;
+
 	inline void operator = (const CRGB c) __attribute__((always_inline))
   { 
 		this->r = c.r;
@@ -81,27 +149,58 @@ struct CRGBW
 		this->w = c.w;
 	}
 
+#ifdef RGBW_SWAR
+  // The whole pixel as one 32-bit word, for the whole-pixel math at the top
+  // of this file. memcpy is the portable way to do that; the compiler turns
+  // it into a single load or store.
+  inline uint32_t word() const __attribute__((always_inline))
+  {
+    uint32_t value;
+    memcpy(&value, raw, 4);
+    return value;
+  }
+
+  inline void setWord(uint32_t value) __attribute__((always_inline))
+  {
+    memcpy(raw, &value, 4);
+  }
+#endif
+
   inline CRGBW& operator+= (const CRGB& rhs ) __attribute__((always_inline))
   {
+#ifdef RGBW_SWAR
+    CRGBW rgb(rhs.r, rhs.g, rhs.b, 0);
+    setWord(rgbwQadd8(word(), rgb.word()));
+    w = 0;       // RGB-Only version.
+#else
     r = qadd8( r, rhs.r);
     g = qadd8( g, rhs.g);
     b = qadd8( b, rhs.b);
     w = 0;       // RGB-Only version.
+#endif
     return *this;
   }
   
   inline CRGBW& operator+=(const CRGBW& rhs) __attribute__((always_inline))
   {
+#ifdef RGBW_SWAR
+    setWord(rgbwQadd8(word(), rhs.word()));
+#else
     r = qadd8( r, rhs.r);
     g = qadd8( g, rhs.g);
     b = qadd8( b, rhs.b);
     w = qadd8( w, rhs.w); // RGBW version.
+#endif
     return *this;
   }
 
   inline CRGBW& nscale8 (uint8_t scaledown ) __attribute__((always_inline))
   {
+#ifdef RGBW_SWAR
+    setWord(rgbwScale8(word(), scaledown));
+#else
     nscale8x4( r, g, b, w, scaledown);
+#endif
     return *this;
   }
 
@@ -123,24 +222,44 @@ inline uint16_t getRGBWsize(uint16_t nleds)
 	else return nbytes / 3;
 }
 
-inline void fill_solid( struct CRGBW * leds, int numToFill, CRGB color)
+inline void fill_solid( struct CRGBW * leds, int numToFill, CRGBW color)
 {
   uint16_t i = numToFill;
   if (numToFill <= 0) return;
+#ifdef RGBW_SWAR
+  uint32_t value = color.word();
+  uint16_t n = 0;
+#if defined(RGBW_SWAR_AVX2)
+  // Eight pixels per store.
+  __m256i values = _mm256_set1_epi32(value);
+  for (; n + 8 <= i; n += 8)
+  {
+    _mm256_storeu_si256((__m256i*)&leds[n], values);
+  }
+#elif defined(RGBW_SWAR_NEON)
+  // Four pixels per store.
+  uint32x4_t values = vdupq_n_u32(value);
+  for (; n + 4 <= i; n += 4)
+  {
+    vst1q_u8(leds[n].raw, vreinterpretq_u8_u32(values));
+  }
+#endif
+  for (; n < i; n++)
+  {
+    leds[n].setWord(value);
+  }
+#else
   while (i--)
   {
     leds[i] = color;
   }
+#endif
 }
 
-inline void fill_solid( struct CRGBW * leds, int numToFill, CRGBW color)
+inline void fill_solid( struct CRGBW * leds, int numToFill, CRGB color)
 {
-  uint16_t i = numToFill;
-  if (numToFill <= 0) return;
-  while (i--)
-  {
-    leds[i] = color;
-  }
+  // The same as filling with the color and the white LED off.
+  fill_solid(leds, numToFill, CRGBW(color.r, color.g, color.b, 0));
 }
 
 template <typename PALETTE>
@@ -158,6 +277,38 @@ inline void nscale8( CRGBW* leds, uint16_t num_leds, uint8_t scale)
 {
   uint16_t i = num_leds;
   if (num_leds <= 0) return;
+#if defined(RGBW_SWAR_AVX2)
+  // Eight pixels at a time: the same split into 16-bit lanes as
+  // rgbwScale8(), with the odd bytes multiplied where they sit, and the
+  // even bytes shifted down after the multiply.
+  const __m256i multiplier = _mm256_set1_epi16((uint16_t)scale + RGBW_SCALE8_FIXED_ADD);
+  const __m256i lowBytes   = _mm256_set1_epi16(0x00FF);
+  while (i >= 8)
+  {
+    i -= 8;
+    __m256i pixels    = _mm256_loadu_si256((const __m256i*)&leds[i]);
+    __m256i evenBytes = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_and_si256(pixels, lowBytes), multiplier), 8);
+    __m256i oddBytes  = _mm256_andnot_si256(lowBytes, _mm256_mullo_epi16(_mm256_srli_epi16(pixels, 8), multiplier));
+    _mm256_storeu_si256((__m256i*)&leds[i], _mm256_or_si256(evenBytes, oddBytes));
+  }
+#elif defined(RGBW_SWAR_NEON)
+  // Four pixels at a time, widening each byte to 16 bits for the multiply.
+  // The "+ 1" of the fixed scale8() is added on as the byte itself, so the
+  // multiplier still fits in 8 bits.
+  const uint8x8_t multiplier = vdup_n_u8(scale);
+  while (i >= 4)
+  {
+    i -= 4;
+    uint8x16_t pixels = vld1q_u8(leds[i].raw);
+    uint16x8_t low    = vmull_u8(vget_low_u8(pixels),  multiplier);
+    uint16x8_t high   = vmull_u8(vget_high_u8(pixels), multiplier);
+#if (RGBW_SCALE8_FIXED_ADD == 1)
+    low  = vaddw_u8(low,  vget_low_u8(pixels));
+    high = vaddw_u8(high, vget_high_u8(pixels));
+#endif
+    vst1q_u8(leds[i].raw, vcombine_u8(vshrn_n_u16(low, 8), vshrn_n_u16(high, 8)));
+  }
+#endif
   while (i--)
   {
       leds[i].nscale8( scale);
@@ -192,15 +343,30 @@ inline void blur1d( CRGBW* leds, uint16_t numLeds, fract8 blur_amount)
   if (numLeds <= 0) return;
   uint8_t keep = 255 - blur_amount;
   uint8_t seep = blur_amount >> 1;
+  // Each pixel picks up the light seeping from the one after it before its
+  // own light is worked out, so the strand has to be done one pixel after
+  // another, and the time taken is the length of that chain. Doing each
+  // pixel as a single 32-bit word makes the chain longer rather than
+  // shorter, so unlike the other helpers, this works one channel at a time
+  // on every processor, where the four channels run side by side.
   CRGBW carryover = CRGBW(0,0,0,0);
   while (i--)
   {
       CRGBW cur = leds[i];
       CRGBW part = cur;
-      part.nscale8( seep);
-      cur.nscale8( keep);
-      cur += carryover;
-      if( i) leds[i-1] += part;
+      nscale8x4( part.r, part.g, part.b, part.w, seep);
+      nscale8x4( cur.r, cur.g, cur.b, cur.w, keep);
+      cur.r = qadd8( cur.r, carryover.r);
+      cur.g = qadd8( cur.g, carryover.g);
+      cur.b = qadd8( cur.b, carryover.b);
+      cur.w = qadd8( cur.w, carryover.w);
+      if( i)
+      {
+        leds[i-1].r = qadd8( leds[i-1].r, part.r);
+        leds[i-1].g = qadd8( leds[i-1].g, part.g);
+        leds[i-1].b = qadd8( leds[i-1].b, part.b);
+        leds[i-1].w = qadd8( leds[i-1].w, part.w);
+      }
       leds[i] = cur;
       carryover = part;
   }
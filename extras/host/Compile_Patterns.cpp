@@ -0,0 +1,424 @@
+// ---------------------------------------------------------------------------
+// Pattern compiler for the Close Encounters Mothership Scanner
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Converts any number of PGM image files into a single header file of pattern
+// arrays, ready to be included by "Close_Encounters_Mothership_Scanner.h".
+// This replaces the old PowerShell script, which converted one file at a time
+// and needed the sizes and widths to be fixed up by hand afterwards.
+//
+// The reason I'm using PGM files is that they are simple to parse. It's easy
+// to create a PGM in most image editors (I'm using GIMP but you can use
+// others): create the image as a grayscale or a black and white image, draw
+// it, and export it to a PGM file. Both the ASCII ("P2") and the binary ("P5")
+// kinds of PGM file are supported. White pixels are lit, black pixels are
+// dark. For the one-bit formats, draw the image as close to pure black and
+// white as you can; any pixel at or above the threshold counts as lit.
+//
+// PGM format:    https://users.wpi.edu/~cfurlong/me-593n/pgmimage.html
+//
+// Each image becomes one array, named "array" plus the file name in
+// CamelCase, plus a suffix for the storage format, for example the file
+// "tony 05.pgm" becomes "arrayTony05Packed". See "Pattern_Encode.h" for the
+// details of each storage format. Each array is followed by its Size and
+// Width constants, worked out from the image, and a commented-out line for
+// the CE3Kpatterns table, which can be pasted into the table as-is.
+//
+// Each image is also checked for how well it wraps around. The scanner
+// scrolls from the bottom row of an image straight back to the top row, and
+// repeats the image side by side along the strand, so a seam at either of
+// those edges shows up as a jump in the animation. If the difference across
+// the top/bottom or left/right seam is larger than the largest difference
+// between any two neighboring rows (or columns) inside the image, the
+// compiler prints a warning; with --strict, that stops the compile instead.
+//
+// Build from the top folder of the repository:
+//
+//   g++ -O2 -o compile_patterns extras/host/Compile_Patterns.cpp
+//
+// Usage:
+//
+//   ./compile_patterns [options] file.pgm [file.pgm ...]
+//
+//   -f, --format FORMAT  Storage format: bytes, packed, gray or rle. The
+//                        default is packed.
+//   -o, --output FILE    Write the header to FILE instead of to the screen.
+//   -t, --threshold N    Brightness from 1 to 255 at which a pixel counts as
+//                        lit, for the one-bit formats. The default is 128.
+//   -s, --strict         Treat wrap-around warnings as errors.
+//
+// For example:
+//
+//   ./compile_patterns --format rle -o My_Patterns.h patterns/*.pgm
+// ---------------------------------------------------------------------------
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "Pattern_Encode.h"
+
+// ---------------------------------------------------------------------------
+// PGM reading
+// ---------------------------------------------------------------------------
+
+// Skip whitespace and "#" comments in the header of a PGM file.
+static void skipPgmSpace(const std::vector<uint8_t>& data, size_t& position)
+{
+  while (position < data.size())
+  {
+    if (data[position] == '#')
+    {
+      while (position < data.size() && data[position] != '\n') { position++; }
+    }
+    else if (isspace(data[position]))
+    {
+      position++;
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+// Read one ASCII number from a PGM file. Returns false if there isn't one.
+static bool readPgmNumber(const std::vector<uint8_t>& data, size_t& position, int& value)
+{
+  skipPgmSpace(data, position);
+  if (position >= data.size() || !isdigit(data[position])) return false;
+  value = 0;
+  while (position < data.size() && isdigit(data[position]))
+  {
+    value = (value * 10) + (data[position++] - '0');
+    if (value > 1000000) return false;
+  }
+  return true;
+}
+
+// Turn a file name into an array name: "array" plus each word of the file
+// name (without its folder or extension) with its first letter capitalized.
+static std::string arrayNameFromFile(const char* path)
+{
+  const char* base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+  const char* backslash = strrchr(base, '\\');
+  if (backslash) { base = backslash + 1; }
+  const char* extension = strrchr(base, '.');
+  size_t length = extension ? (size_t)(extension - base) : strlen(base);
+
+  std::string name = "array";
+  bool startOfWord = true;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = base[i];
+    if (isalnum((unsigned char)c))
+    {
+      name += startOfWord ? (char)toupper((unsigned char)c) : (char)tolower((unsigned char)c);
+      startOfWord = false;
+    }
+    else
+    {
+      startOfWord = true;
+    }
+  }
+  return name;
+}
+
+// Read a P2 or P5 PGM file into an image, scaling its brightness values to
+// the range 0 to 255. Prints an error and returns false if it can't.
+static bool readPgm(const char* path, PatternImage& image)
+{
+  FILE* file = fopen(path, "rb");
+  if (!file)
+  {
+    fprintf(stderr, "Error: can't open %s.\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[65536];
+  size_t  got;
+  while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    data.insert(data.end(), buffer, buffer + got);
+  }
+  fclose(file);
+
+  if (data.size() < 2 || data[0] != 'P' || (data[1] != '2' && data[1] != '5'))
+  {
+    fprintf(stderr, "Error: %s is not a P2 or P5 PGM file.\n", path);
+    return false;
+  }
+  bool   binary   = (data[1] == '5');
+  size_t position = 2;
+  int    maxValue = 0;
+  if (!readPgmNumber(data, position, image.Width) ||
+      !readPgmNumber(data, position, image.Height) ||
+      !readPgmNumber(data, position, maxValue) ||
+      image.Width <= 0 || image.Height <= 0 || maxValue <= 0 || maxValue > 65535)
+  {
+    fprintf(stderr, "Error: %s has a bad PGM header.\n", path);
+    return false;
+  }
+
+  size_t count = (size_t)image.Width * image.Height;
+  image.Name = arrayNameFromFile(path);
+  image.Pixels.resize(count);
+
+  if (binary)
+  {
+    // Exactly one whitespace character separates the header from the pixels,
+    // which are one byte each, or two bytes (most significant first) if the
+    // maximum value is over 255.
+    position++;
+    size_t bytesPerPixel = (maxValue > 255) ? 2 : 1;
+    if (data.size() < position + (count * bytesPerPixel))
+    {
+      fprintf(stderr, "Error: %s is shorter than its %dx%d pixels.\n", path, image.Width, image.Height);
+      return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      int value = data[position++];
+      if (bytesPerPixel == 2) { value = (value << 8) | data[position++]; }
+      image.Pixels[i] = (uint8_t)(((value * 255) + (maxValue / 2)) / maxValue);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      int value;
+      if (!readPgmNumber(data, position, value) || value > maxValue)
+      {
+        fprintf(stderr, "Error: %s has a bad or missing value at pixel %zu.\n", path, i);
+        return false;
+      }
+      image.Pixels[i] = (uint8_t)(((value * 255) + (maxValue / 2)) / maxValue);
+    }
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Wrap-around check
+// ---------------------------------------------------------------------------
+
+// Brightness of a pixel as it will be stored: either the gray level, or 0 or
+// 255 for the one-bit formats.
+static int storedValue(const PatternImage& image, int x, int y, bool oneBit, uint8_t threshold)
+{
+  uint8_t value = image.Pixels[(y * image.Width) + x];
+  if (oneBit) { return (value >= threshold) ? 255 : 0; }
+  return value;
+}
+
+// Total difference between two rows of an image.
+static long rowDifference(const PatternImage& image, int rowA, int rowB, bool oneBit, uint8_t threshold)
+{
+  long total = 0;
+  for (int x = 0; x < image.Width; x++)
+  {
+    total += abs(storedValue(image, x, rowA, oneBit, threshold) - storedValue(image, x, rowB, oneBit, threshold));
+  }
+  return total;
+}
+
+// Total difference between two columns of an image.
+static long columnDifference(const PatternImage& image, int columnA, int columnB, bool oneBit, uint8_t threshold)
+{
+  long total = 0;
+  for (int y = 0; y < image.Height; y++)
+  {
+    total += abs(storedValue(image, columnA, y, oneBit, threshold) - storedValue(image, columnB, y, oneBit, threshold));
+  }
+  return total;
+}
+
+// Compare the seams at the edges of an image with the largest step inside
+// it. Prints a warning for each seam which is worse, and returns the number
+// of warnings.
+static int checkWrapAround(const PatternImage& image, const char* path, bool oneBit, uint8_t threshold)
+{
+  int warnings = 0;
+
+  if (image.Height > 1)
+  {
+    long largestStep = 0;
+    for (int y = 0; y + 1 < image.Height; y++)
+    {
+      long step = rowDifference(image, y, y + 1, oneBit, threshold);
+      if (step > largestStep) { largestStep = step; }
+    }
+    long seam = rowDifference(image, image.Height - 1, 0, oneBit, threshold);
+    if (seam > largestStep)
+    {
+      fprintf(stderr, "Warning: %s does not wrap smoothly from the bottom row to the top row "
+                      "(difference %ld, largest between neighboring rows %ld).\n", path, seam, largestStep);
+      warnings++;
+    }
+  }
+
+  if (image.Width > 1)
+  {
+    long largestStep = 0;
+    for (int x = 0; x + 1 < image.Width; x++)
+    {
+      long step = columnDifference(image, x, x + 1, oneBit, threshold);
+      if (step > largestStep) { largestStep = step; }
+    }
+    long seam = columnDifference(image, image.Width - 1, 0, oneBit, threshold);
+    if (seam > largestStep)
+    {
+      fprintf(stderr, "Warning: %s does not wrap smoothly from the right edge to the left edge "
+                      "(difference %ld, largest between neighboring columns %ld).\n", path, seam, largestStep);
+      warnings++;
+    }
+  }
+
+  return warnings;
+}
+
+// ---------------------------------------------------------------------------
+// Main program
+// ---------------------------------------------------------------------------
+static void printUsage()
+{
+  fprintf(stderr, "Usage: compile_patterns [-f bytes|packed|gray|rle] [-o output.h] [-t threshold] [-s] file.pgm [file.pgm ...]\n");
+}
+
+int main(int argc, char** argv)
+{
+  PatternFormat format    = PATTERN_FORMAT_PACKED;
+  const char*   output    = NULL;
+  int           threshold = 128;
+  bool          strict    = false;
+  std::vector<const char*> inputs;
+
+  for (int a = 1; a < argc; a++)
+  {
+    const char* arg = argv[a];
+    bool hasValue = (a + 1 < argc);
+    if ((!strcmp(arg, "-f") || !strcmp(arg, "--format")) && hasValue)
+    {
+      const char* name = argv[++a];
+      if      (!strcmp(name, "bytes"))  { format = PATTERN_FORMAT_BYTES;  }
+      else if (!strcmp(name, "packed")) { format = PATTERN_FORMAT_PACKED; }
+      else if (!strcmp(name, "gray"))   { format = PATTERN_FORMAT_GRAY;   }
+      else if (!strcmp(name, "rle"))    { format = PATTERN_FORMAT_RLE;    }
+      else
+      {
+        fprintf(stderr, "Error: unknown format \"%s\".\n", name);
+        printUsage();
+        return 1;
+      }
+    }
+    else if ((!strcmp(arg, "-o") || !strcmp(arg, "--output")) && hasValue)
+    {
+      output = argv[++a];
+    }
+    else if ((!strcmp(arg, "-t") || !strcmp(arg, "--threshold")) && hasValue)
+    {
+      threshold = atoi(argv[++a]);
+      if (threshold < 1 || threshold > 255)
+      {
+        fprintf(stderr, "Error: the threshold must be from 1 to 255.\n");
+        return 1;
+      }
+    }
+    else if (!strcmp(arg, "-s") || !strcmp(arg, "--strict"))
+    {
+      strict = true;
+    }
+    else if (arg[0] == '-')
+    {
+      printUsage();
+      return 1;
+    }
+    else
+    {
+      inputs.push_back(arg);
+    }
+  }
+  if (inputs.empty())
+  {
+    printUsage();
+    return 1;
+  }
+
+  // Read and check every image before writing anything, so that a bad file
+  // doesn't leave a half-written header behind.
+  bool oneBit = (format != PATTERN_FORMAT_GRAY);
+  std::vector<PatternImage> images(inputs.size());
+  int warnings = 0;
+  for (size_t i = 0; i < inputs.size(); i++)
+  {
+    if (!readPgm(inputs[i], images[i])) return 1;
+    if (images[i].Width > 0xFFFF || (long)images[i].Width * images[i].Height > 0x7FFF)
+    {
+      fprintf(stderr, "Error: %s is too big; the scanner's Size values are 16-bit ints on the Arduino.\n", inputs[i]);
+      return 1;
+    }
+    for (size_t j = 0; j < i; j++)
+    {
+      if (images[j].Name == images[i].Name)
+      {
+        fprintf(stderr, "Error: %s and %s would both be named %s.\n", inputs[j], inputs[i], images[i].Name.c_str());
+        return 1;
+      }
+    }
+    warnings += checkWrapAround(images[i], inputs[i], oneBit, (uint8_t)threshold);
+  }
+  if (strict && warnings > 0)
+  {
+    fprintf(stderr, "Stopped: %d wrap-around warning(s) with --strict.\n", warnings);
+    return 1;
+  }
+
+  FILE* out = stdout;
+  if (output)
+  {
+    out = fopen(output, "w");
+    if (!out)
+    {
+      fprintf(stderr, "Error: can't write %s.\n", output);
+      return 1;
+    }
+  }
+
+  fprintf(out, "// ---------------------------------------------------------------------------\n");
+  fprintf(out, "// Pattern arrays for the Close Encounters Mothership Scanner, in the\n");
+  fprintf(out, "// %s format. This file is generated by the program\n", patternFormatName[format]);
+  fprintf(out, "// extras/host/Compile_Patterns.cpp; do not edit it by hand. Include it from\n");
+  fprintf(out, "// inside Close_Encounters_Mothership_Scanner.h, next to the other pattern\n");
+  fprintf(out, "// arrays, and add the arrays to the CE3Kpatterns table.\n");
+  fprintf(out, "// ---------------------------------------------------------------------------\n");
+
+  size_t totalBytes = 0;
+  for (size_t i = 0; i < images.size(); i++)
+  {
+    const PatternImage& image = images[i];
+    size_t bytes = writePatternArray(out, image, format, (uint8_t)threshold);
+    if (bytes == 0)
+    {
+      if (output) { fclose(out); remove(output); }
+      return 1;
+    }
+    totalBytes += bytes;
+
+    // Ready-made line for the CE3Kpatterns table, with arrayBlank as the
+    // second array and the scanner's usual speed.
+    std::string name = image.Name + patternFormatSuffix[format];
+    fprintf(out, "// { %s, arrayBlank, %sSize, arrayBlankSize, %sWidth, CE3K_ROWS_PER_SECOND(13.33), %s },\n",
+            name.c_str(), name.c_str(), name.c_str(), patternFormatName[format]);
+  }
+
+  if (output) { fclose(out); }
+  fprintf(stderr, "Compiled %zu pattern(s), %zu bytes of flash memory, %d warning(s).\n", images.size(), totalBytes, warnings);
+  return 0;
+}
@@ -0,0 +1,256 @@
+// ----------------------------------------------------------------------------
+// FastLED.h (host-side stand-in)
+// ----------------------------------------------------------------------------
+//
+// Minimal stand-in for the parts of the Arduino core and the FastLED library
+// that are used by "Close_Encounters_Mothership_Scanner.h" and
+// "FastLED_RGBW_2.h". This is NOT the real FastLED library. It exists only so
+// that the scanner code can be compiled and measured natively on a Linux PC,
+// where it is much easier to time the hot loop than it is on the Arduino.
+//
+// The folder that contains this file is placed first on the include path when
+// compiling the host programs, so that the line "#include <FastLED.h>" picks
+// up this file instead of the real library. The Arduino IDE does not compile
+// anything in the "extras" folder, so this file does not affect the sketch.
+//
+// Timing: millis() returns a virtual clock which only moves when the host
+// program calls hostAdvanceMillis(), or when the code calls delay(). This way
+// a benchmark can make every EVERY_N_MILLISECONDS block fire on demand, and
+// can run thousands of "15 millisecond" frames as fast as the CPU allows.
+// micros() returns real elapsed time, since it is only used for measurement.
+//
+// The random number generator, scale8() and qadd8() use the same math as
+// FastLED, so that the same seed produces the same animation as the Arduino.
+// hsv2rgb_rainbow() is a simplified version of FastLED's conversion; its
+// colors are close, but not bit-identical, to the ones on the real LEDs.
+// ----------------------------------------------------------------------------
+
+#ifndef FastLED_Host_Shim_h
+#define FastLED_Host_Shim_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+// ----------------------------------------------------------------------------
+// Arduino core stand-ins
+// ----------------------------------------------------------------------------
+
+// Flash memory does not exist as a separate address space on the PC, so the
+// PROGMEM tag does nothing and the pgm_read functions are plain reads.
+#define PROGMEM
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)  (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)    (*(void * const *)(addr))
+#define F(string_literal)     (string_literal)
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+// Virtual millisecond clock, see the notes at the top of this file.
+static uint32_t hostMillis = 0;
+
+inline uint32_t millis()                       { return hostMillis; }
+inline void     hostAdvanceMillis(uint32_t ms) { hostMillis += ms; }
+inline void     delay(uint32_t ms)             { hostMillis += ms; }
+
+inline uint32_t micros()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Serial port output goes to stdout.
+class HostSerial
+{
+public:
+  void begin(unsigned long) {}
+  void print(const char* s)    { fputs(s, stdout); }
+  void print(char c)           { fputc(c, stdout); }
+  void print(int v)            { printf("%d", v); }
+  void print(unsigned int v)   { printf("%u", v); }
+  void print(long v)           { printf("%ld", v); }
+  void print(unsigned long v)  { printf("%lu", v); }
+  void print(double v)         { printf("%.2f", v); }
+  void println()               { fputc('\n', stdout); }
+  template <typename T> void println(T v) { print(v); println(); }
+  void write(const uint8_t* data, size_t len) { fwrite(data, 1, len, stdout); }
+};
+static HostSerial Serial __attribute__((unused));
+
+// ----------------------------------------------------------------------------
+// lib8tion stand-ins
+// ----------------------------------------------------------------------------
+#define LIB8STATIC            static inline
+#define SCALE8_C              1
+#define SCALE8_AVRASM         0
+#define FASTLED_SCALE8_FIXED  1
+
+typedef uint8_t fract8;
+
+LIB8STATIC uint8_t scale8(uint8_t i, fract8 scale)
+{
+  return (((uint16_t)i) * (1 + (uint16_t)(scale))) >> 8;
+}
+
+LIB8STATIC uint8_t qadd8(uint8_t i, uint8_t j)
+{
+  unsigned int t = i + j;
+  if (t > 255) t = 255;
+  return t;
+}
+
+LIB8STATIC void memmove8(void* dst, const void* src, uint16_t num)
+{
+  memmove(dst, src, num);
+}
+
+// Same 16-bit linear congruential generator as FastLED's lib8tion/random8.h.
+static uint16_t rand16seed = 1337;
+
+LIB8STATIC void random16_set_seed(uint16_t seed) { rand16seed = seed; }
+
+LIB8STATIC uint16_t random16()
+{
+  rand16seed = (rand16seed * 2053) + 13849;
+  return rand16seed;
+}
+
+LIB8STATIC uint16_t random16(uint16_t lim)
+{
+  return ((uint32_t)lim * (uint32_t)random16()) >> 16;
+}
+
+LIB8STATIC uint8_t random8()
+{
+  rand16seed = (rand16seed * 2053) + 13849;
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+
+LIB8STATIC uint8_t random8(uint8_t lim)
+{
+  return ((uint16_t)random8() * lim) >> 8;
+}
+
+// ----------------------------------------------------------------------------
+// Color types
+// ----------------------------------------------------------------------------
+struct CHSV
+{
+  union
+  {
+    struct
+    {
+      union { uint8_t hue; uint8_t h; };
+      union { uint8_t sat; uint8_t s; };
+      union { uint8_t val; uint8_t v; };
+    };
+    uint8_t raw[3];
+  };
+
+  inline CHSV() {}
+  inline CHSV(uint8_t ih, uint8_t is, uint8_t iv) : h(ih), s(is), v(iv) {}
+};
+
+struct CRGB;
+inline void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+
+struct CRGB
+{
+  union
+  {
+    struct
+    {
+      union { uint8_t r; uint8_t red; };
+      union { uint8_t g; uint8_t green; };
+      union { uint8_t b; uint8_t blue; };
+    };
+    uint8_t raw[3];
+  };
+
+  inline CRGB() {}
+  inline CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  inline CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  inline CRGB(const CHSV& hsv) { hsv2rgb_rainbow(hsv, *this); }
+};
+
+// Simplified rainbow conversion: six 43-step hue sections with linear ramps,
+// then saturation and value applied with scale8. Good enough for benchmarks
+// and for deterministic host-side frame output.
+inline void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb)
+{
+  uint8_t section = hsv.hue / 43;
+  uint8_t ramp    = (hsv.hue - (section * 43)) * 6;
+  uint8_t r, g, b;
+  switch (section)
+  {
+    case 0:  r = 255;        g = ramp;       b = 0;          break;
+    case 1:  r = 255 - ramp; g = 255;        b = 0;          break;
+    case 2:  r = 0;          g = 255;        b = ramp;       break;
+    case 3:  r = 0;          g = 255 - ramp; b = 255;        break;
+    case 4:  r = ramp;       g = 0;          b = 255;        break;
+    default: r = 255;        g = 0;          b = 255 - ramp; break;
+  }
+  uint8_t desat = 255 - hsv.sat;
+  r = qadd8(scale8(r, hsv.sat), desat);
+  g = qadd8(scale8(g, hsv.sat), desat);
+  b = qadd8(scale8(b, hsv.sat), desat);
+  rgb.r = scale8(r, hsv.val);
+  rgb.g = scale8(g, hsv.val);
+  rgb.b = scale8(b, hsv.val);
+}
+
+// Only declared so that the fill_palette() template in FastLED_RGBW_2.h can
+// be parsed; palettes are not used by the scanner.
+enum TBlendType { NOBLEND = 0, LINEARBLEND = 1 };
+
+// ----------------------------------------------------------------------------
+// Timers
+// ----------------------------------------------------------------------------
+
+// Same behavior as FastLED's CEveryNMillis: the block runs once the period has
+// elapsed since the last time it ran (or since the timer was created).
+class CEveryNMillis
+{
+public:
+  uint32_t mPrevTrigger;
+  uint32_t mPeriod;
+
+  CEveryNMillis(uint32_t period) : mPrevTrigger(millis()), mPeriod(period) {}
+
+  bool ready()
+  {
+    bool isReady = (millis() - mPrevTrigger) >= mPeriod;
+    if (isReady) { mPrevTrigger = millis(); }
+    return isReady;
+  }
+  operator bool() { return ready(); }
+};
+
+#define HOST_CONCAT_INNER(a, b)      a##b
+#define HOST_CONCAT(a, b)            HOST_CONCAT_INNER(a, b)
+#define EVERY_N_MILLIS_I(NAME, N)    static CEveryNMillis NAME(N); if (NAME)
+#define EVERY_N_MILLIS(N)            EVERY_N_MILLIS_I(HOST_CONCAT(PER, __COUNTER__), N)
+#define EVERY_N_MILLISECONDS(N)      EVERY_N_MILLIS(N)
+
+// ----------------------------------------------------------------------------
+// Controller stand-in. Output goes nowhere; show() only counts calls.
+// ----------------------------------------------------------------------------
+#define WS2812B 0
+#define RGB     0
+
+class CFastLED
+{
+public:
+  uint32_t showCount = 0;
+
+  template <int CHIPSET, int DATA_PIN, int ORDER>
+  void addLeds(CRGB*, int) {}
+  void setBrightness(uint8_t) {}
+  void setMaxPowerInVoltsAndMilliamps(uint8_t, uint32_t) {}
+  void show() { showCount++; }
+};
+static CFastLED FastLED;
+
+#endif
@@ -0,0 +1,1379 @@
+// ---------------------------------------------------------------------------
+// Host-side frame-time benchmark for the Close Encounters Mothership Scanner
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// This program compiles the scanner code natively on a Linux PC, using the
+// stand-in for FastLED and the Arduino core found in "extras/host/FastLED.h",
+// and then drives ce3kScanner() for a number of frames on several different
+// LED strand lengths. For each strand length it reports the time taken per
+// frame, the number of LEDs rendered per second, and a breakdown of the time
+// spent in each stage of the frame (slit assembly, copying the slit onto the
+// strand, and painting the conversation flashes).
+//
+// The virtual millisecond clock in the stand-in is advanced by one full
+// SCANNER_ANIMATION_SPEED before each call, so every call renders a complete
+// frame, and the pattern rotation and conversation flashes all happen exactly
+// as they would on the Arduino (just faster).
+//
+// Build and run from the top folder of the repository:
+//
+//   g++ -O2 -fpermissive -pthread -I extras/host -o host_benchmark extras/host/Host_Benchmark.cpp
+//   ./host_benchmark [frames]
+//
+// The "-fpermissive" flag matches the Arduino IDE, which also compiles
+// sketches with it. On an x86 PC the row blend uses the SSE2 kernel by
+// default; add "-mavx2" (or "-march=native") to the command to use the AVX2
+// kernel, or "-DCE3K_BLEND_SIMD_OFF" to use the one column at a time version.
+//
+// The longest strand is also run with the frame cache turned on (and two 400
+// LED strands with different cache budgets are checked to draw the same
+// frames), and with zero-copy output (CE3K_ZERO_COPY_OUTPUT), where the time a driver would
+// spend walking the strand description is reported separately. It is run
+// once more on a plain CRGB strand, to compare with the CRGBW version, and
+// with a crossfade between patterns (CE3K_PATTERN_CROSSFADE), where the time
+// taken by the frames during a crossfade is reported separately. Finally, the
+// longest strand is split into eight rings, each run by its own CE3Kscanner,
+// and a large installation of many segments is rendered by the multi-threaded
+// render engine in "Host_Render_Engine.h", with 1, 2, 4, ... threads up to the
+// number of cores, to show how it scales (the "-pthread" flag is for this).
+// Then the shared-time sync (see CE3Kscanner::seek) is checked on a 400 LED
+// strand: scanners which seek to a time must draw the same frames as one
+// which ran all the way there, and a follower kept in step by sync messages
+// over a loopback UDP socket must play the same frames as the leader; and
+// without conversation epochs, scanners which seek to the same time must
+// play the same frames as each other. The reduced quality of an overloaded
+// scanner is checked to start only when frames keep running late, and not
+// after a single late frame. Last, one minute of the longest strand
+// is recorded to a temporary file with the frame recorder in
+// "Host_Frame_Recording.h", and played back from it.
+//
+// Before timing the row blend kernel, the benchmark checks that its output is
+// bit-identical to the one column at a time version, for every one of the 256
+// possible blend weights, and stops if it is not. Likewise, the CRGBW helpers
+// in FastLED_RGBW_2.h (fadeToBlackBy, blur1d, fill_solid and +=) are checked
+// against the same math done one channel at a time, and then timed on a
+// 10000 LED strand. "-mavx2" also turns on their AVX2 versions.
+//
+// Golden frames: to make sure that a speed optimization hasn't changed what
+// ends up on the LEDs, every run of the benchmark first checks the frames
+// against the recording in "extras/host/golden_frames.txt", and stops with an
+// error if any of them differ. To check on their own, or against another
+// recording, or to record them again after a change which is meant to change
+// what ends up on the LEDs:
+//
+//   ./host_benchmark --check [golden.txt] [--dump folder]
+//   ./host_benchmark --record extras/host/golden_frames.txt
+//
+// This renders a fixed number of frames of each pattern in the CE3Kpatterns
+// table on a 400 LED strand, with the conversation flashes running from the
+// same random seed each time, and records a hash of every frame. The check
+// compares every frame against the recording, lists the frames which differ,
+// and exits with an error if there are any. With --dump, each pattern's
+// differing frames are also written to the folder as a PPM image, one row of
+// pixels per frame, with the white LEDs shown as gray under the colors.
+// ---------------------------------------------------------------------------
+
+#include <FastLED.h>
+#include "../../FastLED_RGBW_2.h"
+
+// The blend kernels pull in the system's SIMD headers, so they must be
+// included here at the top level rather than inside the namespaces below.
+#include "../../Close_Encounters_Blend.h"
+
+#include <stdlib.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Per-stage timing hooks, used by the CE3K_STAGE_BEGIN/CE3K_STAGE_END markers
+// in the scanner code. Stage timing is switched off for the pass which
+// measures the total frame time, so that the cost of reading the clock does
+// not pollute the total.
+// ---------------------------------------------------------------------------
+typedef std::chrono::steady_clock BenchClock;
+
+// Number of stages; must match CE3K_NUM_STAGES in the scanner code, which is
+// not defined yet at this point in the file.
+#define BENCH_NUM_STAGES 4
+
+static bool                   benchStageTiming = false;
+static BenchClock::time_point benchStageStart[BENCH_NUM_STAGES];
+static uint64_t               benchStageNanos[BENCH_NUM_STAGES];
+
+static inline void benchStageBegin(int stage)
+{
+  if (benchStageTiming) { benchStageStart[stage] = BenchClock::now(); }
+}
+
+static inline void benchStageEnd(int stage)
+{
+  if (benchStageTiming)
+  {
+    benchStageNanos[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - benchStageStart[stage]).count();
+  }
+}
+
+#define CE3K_STAGE_BEGIN(stage) benchStageBegin(stage)
+#define CE3K_STAGE_END(stage)   benchStageEnd(stage)
+
+// ---------------------------------------------------------------------------
+// One complete copy of the scanner for each strand length. NUM_LEDS is a
+// compile-time constant in the scanner code, so each strand length gets its
+// own namespace with its own leds[] array and its own copy of the scanner
+// state. The include guard is cleared each time so that the header is
+// compiled again inside each namespace.
+// ---------------------------------------------------------------------------
+#define BENCH_STRAND_BEGIN(count)                 \
+  namespace strand##count {                       \
+    bool  colorCyclingIsOn = true;                \
+    CRGBW leds[count];
+
+#define BENCH_STRAND_END(count)                   \
+    uint8_t* ledBytes() { return (uint8_t*)leds; }\
+  }
+
+#define NUM_LEDS 130
+BENCH_STRAND_BEGIN(130)
+#include "../../Close_Encounters_Mothership_Scanner.h"
+BENCH_STRAND_END(130)
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+#define NUM_LEDS 400
+BENCH_STRAND_BEGIN(400)
+#include "../../Close_Encounters_Mothership_Scanner.h"
+BENCH_STRAND_END(400)
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+#define NUM_LEDS 1000
+BENCH_STRAND_BEGIN(1000)
+#include "../../Close_Encounters_Mothership_Scanner.h"
+BENCH_STRAND_END(1000)
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+#define NUM_LEDS 4000
+BENCH_STRAND_BEGIN(4000)
+#include "../../Close_Encounters_Mothership_Scanner.h"
+BENCH_STRAND_END(4000)
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+#define NUM_LEDS 10000
+BENCH_STRAND_BEGIN(10000)
+#include "../../Close_Encounters_Mothership_Scanner.h"
+BENCH_STRAND_END(10000)
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// The longest strand again, this time with the frame cache turned on, with a
+// budget big enough to hold the whole cycle of every pattern.
+#define NUM_LEDS 10000
+#undef  CE3K_FRAME_CACHE_BYTES
+#undef  CE3K_FRAME_CACHE_REPORT
+#define CE3K_FRAME_CACHE_BYTES  393216
+namespace cached10000 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+  uint8_t* ledBytes() { return (uint8_t*)leds; }
+}
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// Two 400 LED strands with the frame cache, one with a budget big enough to
+// hold the whole cycle of every pattern, and one with a budget which holds
+// only the start of each cycle, to check that the frames are the same
+// whether or not they came from the cache.
+#define NUM_LEDS 400
+namespace cachedfull400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef CE3K_FRAME_CACHE_BYTES
+#undef Close_Encounters_Mothership_Scanner_h
+#define CE3K_FRAME_CACHE_BYTES  4096
+namespace cachedsmall400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef CE3K_FRAME_CACHE_BYTES
+#undef CE3K_FRAME_CACHE_REPORT
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// The longest strand again, this time with zero-copy output, where leds[] is
+// never written and a driver walks the slit and patch list instead.
+#define NUM_LEDS 10000
+#undef  CE3K_ZERO_COPY_OUTPUT
+#define CE3K_ZERO_COPY_OUTPUT 1
+namespace zerocopy10000 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+  uint8_t* ledBytes() { return (uint8_t*)leds; }
+}
+#undef CE3K_ZERO_COPY_OUTPUT
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// The longest strand again, this time as a plain CRGB strip without the
+// white LEDs, where the white scanner bars and the flashes share the RGB LEDs.
+#define NUM_LEDS 10000
+namespace rgb10000 {
+  bool colorCyclingIsOn = true;
+  CRGB leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+  uint8_t* ledBytes() { return (uint8_t*)leds; }
+}
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// The longest strand again, this time with a one second crossfade between
+// patterns.
+#define NUM_LEDS 10000
+#undef  CE3K_PATTERN_CROSSFADE
+#define CE3K_PATTERN_CROSSFADE 1000
+namespace crossfade10000 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+  uint8_t* ledBytes() { return (uint8_t*)leds; }
+}
+#undef CE3K_PATTERN_CROSSFADE
+#undef NUM_LEDS
+
+#undef Close_Encounters_Mothership_Scanner_h
+
+// A 400 LED strand for the golden frames, which stays on whichever pattern
+// it is told to run, rather than changing patterns by itself. It also runs
+// the grayscale pattern, which isn't in the default show, so that the
+// grayscale format is covered by the golden frames too.
+#define NUM_LEDS 400
+#undef  CE3K_PATTERN_CHANGE_INTERVAL
+#define CE3K_PATTERN_CHANGE_INTERVAL 3600000UL
+#undef  CE3K_GRAY_PATTERN
+#define CE3K_GRAY_PATTERN 1
+namespace golden400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef CE3K_PATTERN_CHANGE_INTERVAL
+#undef CE3K_GRAY_PATTERN
+#undef NUM_LEDS
+#undef Close_Encounters_Mothership_Scanner_h
+
+// Three 400 LED strands for the shared-time sync check: two with conversation
+// epochs, the way an installation of several controllers is set up, one of
+// which also crossfades between patterns, and one with the default settings,
+// which have no conversation epochs.
+#define NUM_LEDS 400
+#undef  CE3K_CONVERSATION_EPOCH
+#define CE3K_CONVERSATION_EPOCH 3900
+namespace sync400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef Close_Encounters_Mothership_Scanner_h
+#undef  CE3K_PATTERN_CROSSFADE
+#define CE3K_PATTERN_CROSSFADE 1000
+namespace syncfade400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef CE3K_PATTERN_CROSSFADE
+#undef CE3K_CONVERSATION_EPOCH
+#undef CE3K_CONVERSATION_EPOCH_STEPS
+#undef Close_Encounters_Mothership_Scanner_h
+namespace syncdefault400 {
+  bool  colorCyclingIsOn = true;
+  CRGBW leds[NUM_LEDS];
+  #include "../../Close_Encounters_Mothership_Scanner.h"
+}
+#undef NUM_LEDS
+
+// The multi-threaded render engine, for the many-segment benchmark.
+#include "Host_Render_Engine.h"
+
+// The frame recorder and player.
+#include "Host_Frame_Recording.h"
+
+// ---------------------------------------------------------------------------
+// Table of all of the strand lengths which will be benchmarked.
+// ---------------------------------------------------------------------------
+typedef struct
+{
+  int       NumLeds;
+  void    (*Setup)();     // One-time setup (ce3kSetup).
+  void    (*Frame)();     // Renders one frame (one call to ce3kScanner).
+  uint8_t* (*LedBytes)(); // Raw bytes of that strand's leds[] array.
+} BenchStrand;
+
+static const BenchStrand benchStrands[] =
+{
+  { 130,   strand130::ce3kSetup,   strand130::ce3kScanner,   strand130::ledBytes   },
+  { 400,   strand400::ce3kSetup,   strand400::ce3kScanner,   strand400::ledBytes   },
+  { 1000,  strand1000::ce3kSetup,  strand1000::ce3kScanner,  strand1000::ledBytes  },
+  { 4000,  strand4000::ce3kSetup,  strand4000::ce3kScanner,  strand4000::ledBytes  },
+  { 10000, strand10000::ce3kSetup, strand10000::ce3kScanner, strand10000::ledBytes },
+};
+
+// ---------------------------------------------------------------------------
+// Row blend kernel check and benchmark.
+// ---------------------------------------------------------------------------
+
+// Fill a row with pseudo-random darkness values.
+static void fillRandomRow(uint8_t* row, int width)
+{
+  for (int i = 0; i < width; i++) { row[i] = random8(); }
+}
+
+// Compare the SIMD kernel with the scalar kernel. Returns false on mismatch.
+static bool checkBlendKernel()
+{
+  const int maxWidth = 300;
+  uint8_t thisRow[maxWidth];
+  uint8_t nextRow[maxWidth];
+  CRGBW   scalarSlit[maxWidth];
+  CRGBW   kernelSlit[maxWidth];
+
+  for (int blendWeight = 0; blendWeight < 256; blendWeight++)
+  {
+    for (int width = 1; width <= maxWidth; width += 7)
+    {
+      fillRandomRow(thisRow, width);
+      fillRandomRow(nextRow, width);
+      fill_solid(scalarSlit, width, CRGBW(0,0,0,0));
+      fill_solid(kernelSlit, width, CRGBW(0,0,0,0));
+      blendSlitRowsScalar(thisRow, nextRow, blendWeight, scalarSlit, width);
+      blendSlitRows(thisRow, nextRow, blendWeight, kernelSlit, width);
+      if (memcmp(scalarSlit, kernelSlit, width * sizeof(CRGBW)) != 0)
+      {
+        printf("Blend kernel mismatch: blend weight %d, width %d\n", blendWeight, width);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Time one blend kernel on one row width, and return nanoseconds per row.
+static double timeBlendKernel(void (*kernel)(const uint8_t*, const uint8_t*, uint8_t, CRGBW*, uint16_t),
+                              const uint8_t* thisRow, const uint8_t* nextRow, CRGBW* slit, int width)
+{
+  long rows = 20000000L / width;
+  BenchClock::time_point start = BenchClock::now();
+  for (long r = 0; r < rows; r++)
+  {
+    kernel(thisRow, nextRow, (uint8_t)r, slit, width);
+  }
+  uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  return (double)nanos / rows;
+}
+
+static void benchmarkBlendKernel()
+{
+  static const int widths[] = { strand130::WIDEST_ARRAY, 256, 1024, 4096 };
+  static uint8_t thisRow[4096];
+  static uint8_t nextRow[4096];
+  static CRGBW   slit[4096];
+  fillRandomRow(thisRow, 4096);
+  fillRandomRow(nextRow, 4096);
+
+  printf("\nRow blend kernel (%s)\n\n", CE3K_BLEND_KERNEL);
+  printf("%8s %14s %14s %10s\n", "columns", "scalar ns/row", "kernel ns/row", "speedup");
+  for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+  {
+    double scalarNanos = timeBlendKernel(blendSlitRowsScalar, thisRow, nextRow, slit, widths[w]);
+    double kernelNanos = timeBlendKernel(blendSlitRows, thisRow, nextRow, slit, widths[w]);
+    printf("%8d %14.1f %14.1f %9.1fx\n", widths[w], scalarNanos, kernelNanos, scalarNanos / kernelNanos);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// The CRGBW helpers in FastLED_RGBW_2.h, checked and timed against the same
+// operations done one channel at a time with scale8() and qadd8(), which is
+// how they were written before they were changed to work on whole pixels.
+// ---------------------------------------------------------------------------
+static void channelNscale8(CRGBW* leds, uint16_t count, uint8_t scale)
+{
+  for (uint16_t i = 0; i < count; i++)
+  {
+    for (int c = 0; c < 4; c++) { leds[i].raw[c] = scale8(leds[i].raw[c], scale); }
+  }
+}
+
+static void channelBlur1d(CRGBW* leds, uint16_t count, fract8 blurAmount)
+{
+  uint8_t keep = 255 - blurAmount;
+  uint8_t seep = blurAmount >> 1;
+  uint8_t carryover[4] = { 0, 0, 0, 0 };
+  for (uint16_t i = count; i-- > 0; )
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      uint8_t part = scale8(leds[i].raw[c], seep);
+      leds[i].raw[c] = qadd8(scale8(leds[i].raw[c], keep), carryover[c]);
+      if (i) { leds[i - 1].raw[c] = qadd8(leds[i - 1].raw[c], part); }
+      carryover[c] = part;
+    }
+  }
+}
+
+static void channelFillSolid(CRGBW* leds, uint16_t count, CRGBW color)
+{
+  for (uint16_t i = 0; i < count; i++)
+  {
+    for (int c = 0; c < 4; c++) { leds[i].raw[c] = color.raw[c]; }
+  }
+}
+
+static void fillRandomPixels(CRGBW* leds, int count)
+{
+  // Plenty of saturated channels, so that the saturating adds get tested.
+  for (int i = 0; i < count; i++)
+  {
+    for (int c = 0; c < 4; c++) { leds[i].raw[c] = (rand() & 1) ? 255 - (rand() & 15) : rand() & 255; }
+  }
+}
+
+// Check the CRGBW helpers against the one channel at a time versions, on
+// every scale and blur amount, and on strand lengths which exercise both the
+// whole-strand kernels and their leftover pixels.
+static bool checkRgbwHelpers()
+{
+  static const int lengths[] = { 1, 3, 7, 8, 9, 31, 1000 };
+  static CRGBW original[1000], expected[1000], actual[1000];
+  for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+  {
+    int count = lengths[l];
+    for (int amount = 0; amount < 256; amount++)
+    {
+      fillRandomPixels(original, count);
+      const char* failed = NULL;
+
+      std::copy(original, original + count, expected);
+      std::copy(original, original + count, actual);
+      channelNscale8(expected, count, 255 - amount);
+      fadeToBlackBy(actual, count, amount);
+      if (memcmp(expected, actual, count * sizeof(CRGBW)) != 0) { failed = "fadeToBlackBy"; }
+
+      std::copy(original, original + count, expected);
+      std::copy(original, original + count, actual);
+      channelBlur1d(expected, count, amount);
+      blur1d(actual, count, amount);
+      if (memcmp(expected, actual, count * sizeof(CRGBW)) != 0) { failed = "blur1d"; }
+
+      CRGBW color = original[0];
+      channelFillSolid(expected, count, color);
+      fill_solid(actual, count, color);
+      if (memcmp(expected, actual, count * sizeof(CRGBW)) != 0) { failed = "fill_solid"; }
+
+      for (int i = 0; i < count && !failed; i++)
+      {
+        CRGBW sum = original[i];
+        sum += original[count - 1 - i];
+        for (int c = 0; c < 4; c++)
+        {
+          if (sum.raw[c] != qadd8(original[i].raw[c], original[count - 1 - i].raw[c])) { failed = "operator+="; }
+        }
+      }
+
+      if (failed)
+      {
+        printf("CRGBW helper mismatch: %s, amount %d, %d LEDs\n", failed, amount, count);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Time one strand helper, and return nanoseconds per call.
+template <typename HELPER>
+static double timeRgbwHelper(CRGBW* leds, int count, HELPER helper)
+{
+  long calls = 20000000L / count;
+  BenchClock::time_point start = BenchClock::now();
+  for (long c = 0; c < calls; c++)
+  {
+    helper(leds, count, (uint8_t)(c | 1));
+  }
+  uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  return (double)nanos / calls;
+}
+
+static void benchmarkRgbwHelpers()
+{
+  static CRGBW leds[10000];
+  fillRandomPixels(leds, 10000);
+
+  printf("\nCRGBW strand helpers (%s), 10000 LEDs\n\n", RGBW_SWAR_KERNEL);
+  printf("%14s %15s %15s %10s\n", "helper", "channel ns", "helper ns", "speedup");
+  double channelNanos = timeRgbwHelper(leds, 10000, channelNscale8);
+  double helperNanos  = timeRgbwHelper(leds, 10000, [](CRGBW* l, int n, uint8_t a) { fadeToBlackBy(l, n, 255 - a); });
+  printf("%14s %15.0f %15.0f %9.1fx\n", "fadeToBlackBy", channelNanos, helperNanos, channelNanos / helperNanos);
+  channelNanos = timeRgbwHelper(leds, 10000, channelBlur1d);
+  helperNanos  = timeRgbwHelper(leds, 10000, [](CRGBW* l, int n, uint8_t a) { blur1d(l, n, a); });
+  printf("%14s %15.0f %15.0f %9.1fx\n", "blur1d", channelNanos, helperNanos, channelNanos / helperNanos);
+  channelNanos = timeRgbwHelper(leds, 10000, [](CRGBW* l, int n, uint8_t a) { channelFillSolid(l, n, CRGBW(a, a, a, a)); });
+  helperNanos  = timeRgbwHelper(leds, 10000, [](CRGBW* l, int n, uint8_t a) { fill_solid(l, n, CRGBW(a, a, a, a)); });
+  printf("%14s %15.0f %15.0f %9.1fx\n", "fill_solid", channelNanos, helperNanos, channelNanos / helperNanos);
+}
+
+// ---------------------------------------------------------------------------
+// Render engine benchmark: a large installation of many segments, each with
+// its own scanner, rendered by the multi-threaded render engine with more
+// and more threads. The segments' buffers are hashed at the end of each run,
+// which must come out the same for every number of threads.
+// ---------------------------------------------------------------------------
+#define ENGINE_SEGMENTS      48
+#define ENGINE_SEGMENT_LEDS  2000
+
+static uint64_t runRenderEngine(int numThreads, long frames, double* nsPerFrame)
+{
+  typedef HostRenderEngine<strand10000::CE3Kscanner> Engine;
+  Engine engine(numThreads);
+  for (int s = 0; s < ENGINE_SEGMENTS; s++)
+  {
+    engine.addSegment(ENGINE_SEGMENT_LEDS, s % strand10000::NUM_CE3K_PATTERNS, 1337 + s);
+  }
+  engine.start();
+
+  BenchClock::time_point start = BenchClock::now();
+  for (long f = 0; f < frames; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    engine.renderFrame(millis());
+    for (int s = 0; s < ENGINE_SEGMENTS; s++) { engine.scanner(s).clearDirty(); }
+  }
+  uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  *nsPerFrame = (double)nanos / frames;
+
+  uint64_t hash = 14695981039346656037ULL;
+  for (int s = 0; s < ENGINE_SEGMENTS; s++)
+  {
+    const uint8_t* bytes = (const uint8_t*)engine.pixels(s);
+    for (size_t i = 0; i < ENGINE_SEGMENT_LEDS * sizeof(CRGBW); i++)
+    {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+static bool benchmarkRenderEngine(long frames)
+{
+  // Powers of two up to the number of cores, and the number of cores itself.
+  // At least two threads are always run, to check that the result doesn't
+  // change, even on a single core.
+  int cores = (int)std::thread::hardware_concurrency();
+  if (cores < 1) { cores = 1; }
+  std::vector<int> threadCounts;
+  for (int t = 1; t <= cores || t <= 2; t *= 2) { threadCounts.push_back(t); }
+  if (threadCounts.back() < cores) { threadCounts.push_back(cores); }
+
+  printf("\nRender engine, %d segments of %d LEDs (%d LEDs), %d cores\n\n",
+         ENGINE_SEGMENTS, ENGINE_SEGMENT_LEDS, ENGINE_SEGMENTS * ENGINE_SEGMENT_LEDS, cores);
+  printf("%8s %12s %14s %10s %18s\n", "threads", "ns/frame", "LEDs/second", "speedup", "hash");
+  double   singleNanos = 0;
+  uint64_t singleHash  = 0;
+  bool     allMatch    = true;
+  for (size_t i = 0; i < threadCounts.size(); i++)
+  {
+    double   nsPerFrame;
+    uint64_t hash = runRenderEngine(threadCounts[i], frames, &nsPerFrame);
+    if (i == 0) { singleNanos = nsPerFrame; singleHash = hash; }
+    printf("%8d %12.0f %14.0f %9.2fx   %016llx%s\n",
+           threadCounts[i], nsPerFrame, ENGINE_SEGMENTS * ENGINE_SEGMENT_LEDS * 1e9 / nsPerFrame,
+           singleNanos / nsPerFrame, (unsigned long long)hash, (hash == singleHash) ? "" : "  MISMATCH");
+    allMatch &= (hash == singleHash);
+  }
+  return allMatch;
+}
+
+// Stand-in for an LED driver which sends the strand straight from the
+// zero-copy description. Instead of clocking the bytes out of a data pin, it
+// folds them into the same checksum that the table below uses.
+struct BenchDriverSink
+{
+  uint32_t Checksum;
+  void operator()(const CRGBW* pixels, uint16_t count)
+  {
+    const uint8_t* bytes = (const uint8_t*)pixels;
+    for (uint32_t i = 0; i < count * sizeof(CRGBW); i++)
+    {
+      Checksum = (Checksum * 31) + bytes[i];
+    }
+  }
+};
+
+// Run a number of frames of one strand, and return the elapsed nanoseconds.
+static uint64_t runFrames(const BenchStrand& strand, long frames)
+{
+  BenchClock::time_point start = BenchClock::now();
+  for (long f = 0; f < frames; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    strand.Frame();
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+}
+
+// ---------------------------------------------------------------------------
+// Golden frames (see the notes at the top of this file).
+// ---------------------------------------------------------------------------
+#define GOLDEN_FRAMES_PER_PATTERN 600
+#define GOLDEN_FRAMES_FILE        "extras/host/golden_frames.txt"
+
+// 64-bit FNV-1a hash of the strand.
+static uint64_t hashStrand(const CRGBW* strand, int count)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const uint8_t* bytes = (const uint8_t*)strand;
+  for (size_t i = 0; i < count * sizeof(CRGBW); i++)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Render the golden frames of one pattern, calling "frameDone" after each one.
+template <typename FRAME_DONE>
+static void renderGoldenFrames(int patternIndex, FRAME_DONE frameDone)
+{
+  using namespace golden400;
+  if (patternIndex == 0) { ce3kSetup(); }
+  ce3kMainScanner.randomSeed = 1337;
+  ce3kMainScanner.scrollPosition = 0;
+  ce3kMainScanner.activatePattern(patternIndex);
+  for (int f = 0; f < GOLDEN_FRAMES_PER_PATTERN; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    ce3kScanner();
+    frameDone(f);
+  }
+}
+
+// Write the hash of every golden frame to a file.
+static int recordGoldenFrames(const char* path)
+{
+  FILE* file = fopen(path, "w");
+  if (!file)
+  {
+    printf("Can't write %s\n", path);
+    return 1;
+  }
+  fprintf(file, "# CE3K golden frames: %d patterns, %d LEDs, %d frames per pattern\n",
+          golden400::NUM_CE3K_PATTERNS, 400, GOLDEN_FRAMES_PER_PATTERN);
+  for (int p = 0; p < golden400::NUM_CE3K_PATTERNS; p++)
+  {
+    renderGoldenFrames(p, [&](int f)
+    {
+      fprintf(file, "%d %d %016llx\n", p, f, (unsigned long long)hashStrand(golden400::leds, 400));
+    });
+  }
+  fclose(file);
+  printf("Recorded %d golden frames to %s\n", golden400::NUM_CE3K_PATTERNS * GOLDEN_FRAMES_PER_PATTERN, path);
+  return 0;
+}
+
+// Write a pattern's differing frames to a PPM image, one row per frame.
+static void dumpGoldenFrames(const char* folder, int patternIndex, const std::vector<uint8_t>& rows, int numRows)
+{
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/pattern%d.ppm", folder, patternIndex);
+  FILE* file = fopen(path, "wb");
+  if (!file)
+  {
+    printf("Can't write %s\n", path);
+    return;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", 400, numRows);
+  fwrite(rows.data(), 1, rows.size(), file);
+  fclose(file);
+  printf("  Wrote %s\n", path);
+}
+
+// Compare every golden frame with a recording. Returns the number of frames
+// which differ, or -1 if the recording can't be used.
+static long checkGoldenFrames(const char* path, const char* dumpFolder)
+{
+  FILE* file = fopen(path, "r");
+  if (!file)
+  {
+    printf("Can't read %s\n", path);
+    return -1;
+  }
+  int patterns = 0, numLeds = 0, framesPerPattern = 0;
+  if (fscanf(file, "# CE3K golden frames: %d patterns, %d LEDs, %d frames per pattern\n",
+             &patterns, &numLeds, &framesPerPattern) != 3 ||
+      numLeds != 400 || framesPerPattern != GOLDEN_FRAMES_PER_PATTERN)
+  {
+    printf("%s is not a golden frame recording from this version of the benchmark\n", path);
+    fclose(file);
+    return -1;
+  }
+  std::vector<uint64_t> golden((size_t)patterns * framesPerPattern);
+  int p, f;
+  unsigned long long hash;
+  while (fscanf(file, "%d %d %llx\n", &p, &f, &hash) == 3)
+  {
+    if (p >= 0 && p < patterns && f >= 0 && f < framesPerPattern) { golden[((size_t)p * framesPerPattern) + f] = hash; }
+  }
+  fclose(file);
+  if (patterns != golden400::NUM_CE3K_PATTERNS)
+  {
+    printf("Note: the recording has %d patterns, the pattern table has %d; checking the first %d\n",
+           patterns, golden400::NUM_CE3K_PATTERNS, (patterns < golden400::NUM_CE3K_PATTERNS) ? patterns : golden400::NUM_CE3K_PATTERNS);
+  }
+
+  long differing = 0;
+  for (int pattern = 0; pattern < golden400::NUM_CE3K_PATTERNS && pattern < patterns; pattern++)
+  {
+    std::vector<uint8_t> rows;
+    int numRows = 0;
+    int firstBad = -1, badFrames = 0;
+    renderGoldenFrames(pattern, [&](int frame)
+    {
+      if (hashStrand(golden400::leds, 400) == golden[((size_t)pattern * framesPerPattern) + frame]) return;
+      if (firstBad < 0) { firstBad = frame; }
+      badFrames++;
+      if (dumpFolder)
+      {
+        for (int i = 0; i < 400; i++)
+        {
+          const CRGBW& pixel = golden400::leds[i];
+          rows.push_back(qadd8(pixel.white, pixel.red));
+          rows.push_back(qadd8(pixel.white, pixel.green));
+          rows.push_back(qadd8(pixel.white, pixel.blue));
+        }
+        numRows++;
+      }
+    });
+    if (badFrames == 0)
+    {
+      printf("Pattern %d: all %d frames match\n", pattern, framesPerPattern);
+      continue;
+    }
+    printf("Pattern %d: %d of %d frames differ, starting at frame %d\n", pattern, badFrames, framesPerPattern, firstBad);
+    if (dumpFolder) { dumpGoldenFrames(dumpFolder, pattern, rows, numRows); }
+    differing += badFrames;
+  }
+  return differing;
+}
+
+// ---------------------------------------------------------------------------
+// Shared-time sync: a scanner which seeks straight to the shared time of one
+// which has been running all along must draw exactly the same frame, and a
+// follower which is kept in step by sync messages, sent to it over a UDP
+// socket on the loopback interface, must play exactly the same frames as the
+// leader whenever their shared times agree. The follower is stalled for a
+// second and a half partway through, so that it has to catch up again.
+// ---------------------------------------------------------------------------
+#define SYNC_FRAMES 8000
+
+template <typename SCANNER>
+static bool checkSync(const char* name, SCANNER& leader, SCANNER& other, CRGBW* leaderLeds, CRGBW* otherLeds)
+{
+  // Seeking, every 37 frames, which lands in plenty of crossfades too.
+  long     seeks = 0, seekMismatches = 0;
+  uint64_t seekNanos = 0, worstSeekNanos = 0;
+  leader.setup(leaderLeds, 400, 0, 1337);
+  for (long f = 0; f < SYNC_FRAMES; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    leader.update(millis());
+    if (f % 37 != 0) continue;
+
+    other.setup(otherLeds, 400, 0, 1337);
+    BenchClock::time_point start = BenchClock::now();
+    other.seek(leader.sharedTime(millis()), millis());
+    uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+    other.update(millis());
+    seekNanos += nanos;
+    if (nanos > worstSeekNanos) { worstSeekNanos = nanos; }
+    seeks++;
+    if (memcmp(leaderLeds, otherLeds, 400 * sizeof(CRGBW)) != 0) { seekMismatches++; }
+  }
+
+  // Loopback sync. The follower is set up two minutes after the leader, so
+  // it starts out far behind.
+  int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+  int sender   = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+  memset(&address, 0, sizeof(address));
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port        = 0;
+  if (receiver < 0 || sender < 0 ||
+      bind(receiver, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      getsockname(receiver, (struct sockaddr*)&address, &addressLength) != 0)
+  {
+    printf("Can't open a UDP socket on the loopback interface\n");
+    if (receiver >= 0) { close(receiver); }
+    if (sender >= 0)   { close(sender); }
+    return false;
+  }
+
+  leader.setup(leaderLeds, 400, 0, 1337);
+  for (long f = 0; f < 120000 / SCANNER_ANIMATION_SPEED; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    leader.update(millis());
+  }
+  other.setup(otherLeds, 400, 0, 1337);
+
+  long messages = 0, rejected = 0, resyncs = 0, compared = 0, mismatches = 0;
+  for (long f = 0; f < SYNC_FRAMES; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    uint32_t now = millis();
+
+    // About once a second, the leader sends its shared time. Every tenth
+    // message is damaged on the way, and must be thrown away.
+    if (f % 67 == 0)
+    {
+      uint8_t message[CE3K_SYNC_MESSAGE_SIZE];
+      sync400::ce3kWriteSyncMessage(message, leader.sharedTime(now));
+      if (messages % 10 == 9) { message[5] ^= 0x10; }
+      sendto(sender, message, sizeof(message), 0, (struct sockaddr*)&address, sizeof(address));
+      messages++;
+    }
+    uint8_t received[CE3K_SYNC_MESSAGE_SIZE];
+    uint32_t time;
+    while (recv(receiver, received, sizeof(received), MSG_DONTWAIT) == (ssize_t)sizeof(received))
+    {
+      if (!sync400::ce3kReadSyncMessage(received, &time)) { rejected++; continue; }
+      if (other.syncTo(time, now)) { resyncs++; }
+    }
+
+    leader.update(now);
+    if (f >= 3000 && f < 3100) continue;   // The follower's stall.
+    other.update(now);
+    if (leader.sharedTime(now) == other.sharedTime(now))
+    {
+      compared++;
+      if (memcmp(leaderLeds, otherLeds, 400 * sizeof(CRGBW)) != 0) { mismatches++; }
+    }
+  }
+  close(receiver);
+  close(sender);
+
+  printf("Shared-time sync, 400 LEDs%s: %ld of %ld seeks differ, %.0f ns/seek (worst %.0f); loopback: %ld messages, %ld damaged, %ld resyncs, %ld of %ld frames in step differ\n",
+         name, seekMismatches, seeks, (double)seekNanos / seeks, (double)worstSeekNanos,
+         messages, rejected, resyncs, mismatches, compared);
+  return seekMismatches == 0 && mismatches == 0 && rejected == messages / 10 && resyncs == 2 && compared > SYNC_FRAMES * 9 / 10;
+}
+
+// ---------------------------------------------------------------------------
+// Shared-time sync with the default settings, which have no conversation
+// epochs. A scanner which seeks can't play the same flashes as one which has
+// been running all along, but its scanner bars must be the same, and two
+// scanners which seek to the same time must play exactly the same frames
+// from then on, even though the random numbers of one of them had got
+// somewhere else first.
+// ---------------------------------------------------------------------------
+static bool checkSyncWithoutEpochs()
+{
+  using namespace syncdefault400;
+  static CE3Kscanner runner, fresh;
+  static CRGBW       runnerLeds[400], freshLeds[400];
+
+  // The runner starts a minute before the leader, so that its conversation
+  // has gone its own way by the time of the first seek.
+  runner.setup(runnerLeds, 400, 0, 1337);
+  for (long f = 0; f < 60000 / SCANNER_ANIMATION_SPEED; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    runner.update(millis());
+  }
+  ce3kSetup();
+
+  long seeks = 0, barMismatches = 0, compared = 0, mismatches = 0;
+  for (long f = 0; f < SYNC_FRAMES; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    uint32_t now = millis();
+    ce3kScanner();
+    if (f % 37 == 0)
+    {
+      fresh.setup(freshLeds, 400, 0, 1337);
+      fresh.seek(ce3kMainScanner.sharedTime(now), now);
+      runner.seek(ce3kMainScanner.sharedTime(now), now);
+      seeks++;
+    }
+    fresh.update(now);
+    runner.update(now);
+    for (int i = 0; i < 400; i++)
+    {
+      if (leds[i].white != freshLeds[i].white) { barMismatches++; break; }
+    }
+    compared++;
+    if (memcmp(runnerLeds, freshLeds, sizeof(freshLeds)) != 0) { mismatches++; }
+  }
+
+  printf("Shared-time sync, 400 LEDs with the default settings (no epochs): %ld seeks, %ld of %ld frames with different bars from the leader, %ld of %ld frames differ between two scanners which seek\n",
+         seeks, barMismatches, compared, mismatches, compared);
+  return barMismatches == 0 && mismatches == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Overload: a single late frame mustn't put the scanner into reduced quality,
+// but frames which keep running late must, and it must come back to full
+// quality once the frames are on time again (see CE3K_OVERLOAD_FRAMES).
+// ---------------------------------------------------------------------------
+static bool checkOverload()
+{
+  using namespace strand400;
+  static CE3Kscanner scanner;
+  static CRGBW       scannerLeds[400];
+  scanner.setup(scannerLeds, 400);
+  uint32_t now = millis();
+  auto onTime = [&](int count) { while (count--) { now += SCANNER_ANIMATION_SPEED;     scanner.update(now); } };
+  auto late   = [&](int count) { while (count--) { now += SCANNER_ANIMATION_SPEED * 3; scanner.update(now); } };
+
+  // One late frame, in the middle of on-time frames.
+  onTime(100);
+  late(1);
+  bool singleLate = scanner.overloaded();
+  onTime(100);
+
+  // Late frames in a row, and then on time again.
+  late(CE3K_OVERLOAD_LATE_FRAMES);
+  bool persistentLate = scanner.overloaded();
+  onTime(CE3K_OVERLOAD_FRAMES);
+  bool recovered = !scanner.overloaded();
+
+  // A late frame every third frame, which is still overloaded, even though
+  // the late frames never come in a row.
+  for (int i = 0; i < CE3K_OVERLOAD_LATE_FRAMES; i++)
+  {
+    late(1);
+    onTime(2);
+  }
+  bool intermittentLate = scanner.overloaded();
+
+  printf("Overload, 400 LEDs: %s after a single late frame, %s after %d late frames in a row, %s after %d on-time frames, %s with every third frame late\n",
+         singleLate ? "overloaded" : "not overloaded",
+         persistentLate ? "overloaded" : "not overloaded", CE3K_OVERLOAD_LATE_FRAMES,
+         recovered ? "recovered" : "still overloaded", CE3K_OVERLOAD_FRAMES,
+         intermittentLate ? "overloaded" : "not overloaded");
+  return !singleLate && persistentLate && recovered && intermittentLate;
+}
+
+// ---------------------------------------------------------------------------
+// Frame recording: one minute of the 10000 LED strand, which is one trip
+// through every pattern in the rotation, recorded with the frame recorder in
+// "Host_Frame_Recording.h" and played back from the file. Every frame played
+// back is checked against a hash of the frame that was recorded, and the
+// playback is timed both straight through and seeking to random frames.
+// ---------------------------------------------------------------------------
+#define RECORDING_MILLISECONDS 60000
+
+static bool benchmarkFrameRecording()
+{
+  using namespace strand10000;
+  long numFrames = RECORDING_MILLISECONDS / SCANNER_ANIMATION_SPEED;
+  char path[] = "/tmp/ce3k_frames_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0)
+  {
+    printf("\nCan't create a temporary file for the frame recording\n");
+    return false;
+  }
+  close(fd);
+
+  // Record, keeping a hash of each frame to check the playback against.
+  ce3kSetup();
+  HostFrameRecorder<CRGBW> recorder;
+  std::vector<uint64_t> hashes;
+  uint64_t recordNanos = 0;
+  bool ok = recorder.open(path, 10000, SCANNER_ANIMATION_SPEED);
+  for (long f = 0; f < numFrames && ok; f++)
+  {
+    hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+    ce3kScanner();
+    hashes.push_back(hashStrand(leds, 10000));
+    BenchClock::time_point start = BenchClock::now();
+    ok = recorder.addFrame(leds, ce3kMainScanner.shownSlitWidth);
+    recordNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  }
+  ok = recorder.close() && ok;
+
+  HostFramePlayer<CRGBW> player;
+  if (!ok || !player.open(path))
+  {
+    unlink(path);
+    return false;
+  }
+  printf("\nFrame recording, 10000 LEDs, %ld frames: %.1f MB (%.1f%% of raw frames), %u raw, %u slit and %u repeated frames, %.0f ns/frame to record\n",
+         numFrames, recorder.bytesWritten() / 1e6, 100.0 * recorder.bytesWritten() / ((double)numFrames * 10000 * sizeof(CRGBW)),
+         recorder.rawFrames(), recorder.slitFrames(), recorder.repeatedFrames(), (double)recordNanos / numFrames);
+
+  // Check every frame.
+  long differing = 0;
+  static CRGBW expanded[10000];
+  for (long f = 0; f < numFrames; f++)
+  {
+    player.expandFrame(f, expanded);
+    if (hashStrand(expanded, 10000) != hashes[f]) { differing++; }
+  }
+
+  // Play the whole recording through the driver stand-in, once in order and
+  // once seeking to a random frame each time.
+  BenchDriverSink driver = { 0 };
+  BenchClock::time_point start = BenchClock::now();
+  for (long f = 0; f < numFrames; f++)
+  {
+    player.streamFrame(f, driver);
+  }
+  uint64_t sequentialNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  start = BenchClock::now();
+  for (long f = 0; f < numFrames; f++)
+  {
+    player.streamFrame(rand() % numFrames, driver);
+  }
+  uint64_t seekNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+  player.close();
+  unlink(path);
+
+  double sequentialFrameNanos = (double)sequentialNanos / numFrames;
+  printf("Frame playback, 10000 LEDs: %.0f ns/frame (%.0f fps) in order, %.0f ns/frame seeking to random frames, %ld of %ld frames differ, checksum %08x\n",
+         sequentialFrameNanos, 1e9 / sequentialFrameNanos, (double)seekNanos / numFrames, differing, numFrames, driver.Checksum);
+  return differing == 0;
+}
+
+int main(int argc, char** argv)
+{
+  // Golden frame modes.
+  if (argc > 2 && !strcmp(argv[1], "--record"))
+  {
+    return recordGoldenFrames(argv[2]);
+  }
+  if (argc > 1 && !strcmp(argv[1], "--check"))
+  {
+    int next = 2;
+    const char* path = (argc > next && strcmp(argv[next], "--dump")) ? argv[next++] : GOLDEN_FRAMES_FILE;
+    const char* dumpFolder = (argc > next + 1 && !strcmp(argv[next], "--dump")) ? argv[next + 1] : NULL;
+    long differing = checkGoldenFrames(path, dumpFolder);
+    if (differing == 0) { printf("All golden frames match\n"); }
+    return (differing == 0) ? 0 : 1;
+  }
+
+  long frames = (argc > 1) ? atol(argv[1]) : 5000;
+  if (frames < 1) { frames = 1; }
+
+  // The golden frames come first, since there is no point in timing frames
+  // which are wrong.
+  long differing = checkGoldenFrames(GOLDEN_FRAMES_FILE, NULL);
+  if (differing != 0)
+  {
+    printf("Golden frame check against %s failed\n", GOLDEN_FRAMES_FILE);
+    return 1;
+  }
+  printf("All golden frames match\n\n");
+
+  if (!checkBlendKernel() || !checkRgbwHelpers())
+  {
+    return 1;
+  }
+
+  printf("CE3K scanner host benchmark, %ld frames per strand length\n\n", frames);
+  printf("%8s %12s %14s %10s %10s %10s %10s\n",
+         "LEDs", "ns/frame", "LEDs/second", "slit ns", "copy ns", "convo ns", "checksum");
+
+  uint64_t liveNanos = 0, liveSlitNanos = 0;   // 10000 LED strand, for the frame cache below.
+  for (size_t s = 0; s < sizeof(benchStrands) / sizeof(benchStrands[0]); s++)
+  {
+    const BenchStrand& strand = benchStrands[s];
+
+    // Set up, and warm up.
+    strand.Setup();
+    runFrames(strand, 100);
+
+    // Pass 1: total frame time, with stage timing switched off.
+    benchStageTiming = false;
+    uint64_t totalNanos = runFrames(strand, frames);
+
+    // Pass 2: per-stage breakdown.
+    memset(benchStageNanos, 0, sizeof(benchStageNanos));
+    benchStageTiming = true;
+    runFrames(strand, frames);
+    benchStageTiming = false;
+
+    // Simple checksum of the final frame, so that the output of different
+    // versions of the code can be compared at a glance.
+    uint32_t checksum = 0;
+    uint8_t* bytes = strand.LedBytes();
+    for (long i = 0; i < strand.NumLeds * (long)sizeof(CRGBW); i++)
+    {
+      checksum = (checksum * 31) + bytes[i];
+    }
+
+    double nsPerFrame = (double)totalNanos / frames;
+    if (strand.NumLeds == 10000)
+    {
+      liveNanos     = totalNanos;
+      liveSlitNanos = benchStageNanos[CE3K_STAGE_SLIT];
+    }
+    printf("%8d %12.0f %14.0f %10.0f %10.0f %10.0f   %08x\n",
+           strand.NumLeds,
+           nsPerFrame,
+           strand.NumLeds * 1e9 / nsPerFrame,
+           (double)benchStageNanos[CE3K_STAGE_SLIT] / frames,
+           (double)benchStageNanos[CE3K_STAGE_COPY] / frames,
+           (double)benchStageNanos[CE3K_STAGE_CONVERSATION] / frames,
+           checksum);
+  }
+
+  // Frame cache: the same frames as the 10000 LED strand, using the cache.
+  // The cache only speeds up the slit stage, which is a small part of a frame
+  // on a strand this long, and only on the frames which it serves, so the
+  // slit stage of those frames is timed separately from the frames which are
+  // rendered live. The cache is filled in as the patterns run, so the frames
+  // it serves are the ones of patterns whose cycle is shorter than
+  // CE3K_PATTERN_CHANGE_INTERVAL.
+  {
+    BenchStrand cached = { 10000, cached10000::ce3kSetup, cached10000::ce3kScanner, cached10000::ledBytes };
+    cached10000::CE3Kscanner& scanner = cached10000::ce3kMainScanner;
+    cached.Setup();
+    runFrames(cached, 100);
+    uint64_t totalNanos = runFrames(cached, frames);
+
+    // Second pass, one frame at a time, sorting the slit stage times by
+    // whether the frame came from the cache.
+    uint64_t hitSlitNanos = 0, liveSlitNanosCached = 0;
+    long hitFrames = 0;
+    benchStageTiming = true;
+    for (long f = 0; f < frames; f++)
+    {
+      uint32_t hits = scanner.frameCacheHits;
+      benchStageNanos[CE3K_STAGE_SLIT] = 0;
+      hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+      cached.Frame();
+      if (scanner.frameCacheHits == hits + 1)
+      {
+        hitSlitNanos += benchStageNanos[CE3K_STAGE_SLIT];
+        hitFrames++;
+      }
+      else
+      {
+        liveSlitNanosCached += benchStageNanos[CE3K_STAGE_SLIT];
+      }
+    }
+    benchStageTiming = false;
+    printf("\nFrame cache (%d byte budget), 10000 LEDs: %.0f ns/frame (%.0f without the cache), %.1f%% of frames from the cache, "
+           "slit %.0f ns/frame from the cache, %.0f ns/frame rendered (%.0f without the cache)\n",
+           393216, (double)totalNanos / frames, (double)liveNanos / frames, 100.0 * hitFrames / frames,
+           hitFrames ? (double)hitSlitNanos / hitFrames : 0.0,
+           (frames > hitFrames) ? (double)liveSlitNanosCached / (frames - hitFrames) : 0.0,
+           (double)liveSlitNanos / frames);
+
+    // The frames served from the cache, and the frames beyond what fits in
+    // it, must both be rounded to the same blend steps, so the strand must
+    // look the same whatever the budget. One full trip through the pattern
+    // rotation, and then some.
+    long cacheFrames = (cachedfull400::NUM_CE3K_PATTERNS * CE3K_PATTERN_CHANGE_INTERVAL) / SCANNER_ANIMATION_SPEED + 1000;
+    long mismatches = 0, fullHits = 0, smallHits = 0;
+    cachedfull400::ce3kSetup();
+    cachedsmall400::ce3kSetup();
+    for (long f = 0; f < cacheFrames; f++)
+    {
+      uint32_t fullBefore  = cachedfull400::ce3kMainScanner.frameCacheHits;
+      uint32_t smallBefore = cachedsmall400::ce3kMainScanner.frameCacheHits;
+      hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+      cachedfull400::ce3kScanner();
+      cachedsmall400::ce3kScanner();
+      if (cachedfull400::ce3kMainScanner.frameCacheHits == fullBefore + 1)   { fullHits++; }
+      if (cachedsmall400::ce3kMainScanner.frameCacheHits == smallBefore + 1) { smallHits++; }
+      if (memcmp(cachedfull400::leds, cachedsmall400::leds, sizeof(cachedfull400::leds)) != 0) { mismatches++; }
+    }
+    printf("Frame cache budgets, 400 LEDs: %ld of %ld frames differ between a %d byte and a %d byte budget (%.1f%% and %.1f%% of frames from the cache)\n",
+           mismatches, cacheFrames, 393216, 4096, 100.0 * fullHits / cacheFrames, 100.0 * smallHits / cacheFrames);
+    if (mismatches != 0)
+    {
+      printf("\nThe frame cache's output depends on its budget\n");
+      return 1;
+    }
+  }
+
+  // Dirty-range tracking: run the 400 LED strand the way the sketch does,
+  // with loop() called once per millisecond, and count how many of those
+  // loops actually changed the strand and would need FastLED.show().
+  {
+    long loops = (long)frames * SCANNER_ANIMATION_SPEED;
+    long changedLoops = 0;
+    uint64_t dirtyLeds = 0;
+    for (long l = 0; l < loops; l++)
+    {
+      hostAdvanceMillis(1);
+      strand400::ce3kScanner();
+      if (strand400::ce3kFrameChanged)
+      {
+        changedLoops++;
+        dirtyLeds += strand400::ce3kDirtyMax - strand400::ce3kDirtyMin + 1;
+        strand400::ce3kClearDirty();
+      }
+    }
+    printf("\nDirty tracking, 400 LEDs, 1 ms loops: %.1f%% of loops changed the strand, average dirty range %.0f LEDs\n",
+           100.0 * changedLoops / loops, changedLoops ? (double)dirtyLeds / changedLoops : 0.0);
+  }
+
+  // Zero-copy output: the same frames as the 10000 LED strand, where the
+  // scanner only describes the strand. The driver time is the cost of walking
+  // that description once per frame, which any driver must pay anyway while
+  // it clocks the data out.
+  {
+    BenchStrand zeroCopy = { 10000, zerocopy10000::ce3kSetup, zerocopy10000::ce3kScanner, zerocopy10000::ledBytes };
+    zeroCopy.Setup();
+    runFrames(zeroCopy, 100);
+    uint64_t renderNanos = runFrames(zeroCopy, frames);
+    BenchDriverSink driver = { 0 };
+    BenchClock::time_point start = BenchClock::now();
+    for (long f = 0; f < frames; f++)
+    {
+      driver.Checksum = 0;
+      zerocopy10000::ce3kStreamStrand(zerocopy10000::ce3kStrandFrame, driver);
+    }
+    uint64_t driverNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+    printf("Zero-copy output, 10000 LEDs: %.0f ns/frame rendering, %.0f ns/frame walked by the driver, checksum %08x\n",
+           (double)renderNanos / frames, (double)driverNanos / frames, driver.Checksum);
+  }
+
+  // CRGB strip: the same frames as the 10000 LED strand, with the white
+  // scanner bars stored as gray and the flashes added on top of them.
+  {
+    BenchStrand rgb = { 10000, rgb10000::ce3kSetup, rgb10000::ce3kScanner, rgb10000::ledBytes };
+    rgb.Setup();
+    runFrames(rgb, 100);
+    uint64_t totalNanos = runFrames(rgb, frames);
+    uint32_t checksum = 0;
+    uint8_t* bytes = rgb.LedBytes();
+    for (long i = 0; i < rgb.NumLeds * (long)sizeof(CRGB); i++)
+    {
+      checksum = (checksum * 31) + bytes[i];
+    }
+    printf("CRGB strip, 10000 LEDs: %.0f ns/frame, checksum %08x\n",
+           (double)totalNanos / frames, checksum);
+  }
+
+  // Power estimate: check the estimate which the scanner keeps up to date
+  // from the slit against adding up every pixel of the strand, the way
+  // FastLED's power limiter does, on the CRGBW and CRGB strands.
+  {
+    long     mismatches = 0;
+    uint64_t scanNanos  = 0;
+    strand10000::ce3kSetup();
+    rgb10000::ce3kSetup();
+    for (long f = 0; f < frames; f++)
+    {
+      hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+      strand10000::ce3kScanner();
+      rgb10000::ce3kScanner();
+
+      BenchClock::time_point start = BenchClock::now();
+      uint32_t scanned = 0;
+      for (int i = 0; i < 10000; i++) { scanned += strand10000::CE3KledOps::power(strand10000::leds[i]); }
+      scanNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+      if ((scanned >> 8) + (10000 * CE3K_POWER_DARK_MW) != strand10000::ce3kPowerMilliwatts()) { mismatches++; }
+
+      scanned = 0;
+      for (int i = 0; i < 10000; i++) { scanned += rgb10000::CE3KledOps::power(rgb10000::leds[i]); }
+      if ((scanned >> 8) + (10000 * CE3K_POWER_DARK_MW) != rgb10000::ce3kPowerMilliwatts()) { mismatches++; }
+    }
+    printf("Power estimate, 10000 LEDs: %.0f ns/frame to scan the whole strand instead, %ld of %ld estimates differ from the scan, last frame %u mW\n",
+           (double)scanNanos / frames, mismatches, frames * 2, strand10000::ce3kPowerMilliwatts());
+    if (mismatches > 0)
+    {
+      return 1;
+    }
+  }
+
+  // Crossfade: the 10000 LED strand again, for one minute, which runs
+  // through several pattern changes, timing the frames during a crossfade
+  // separately from the rest.
+  {
+    crossfade10000::ce3kSetup();
+    long     crossfadeLength = 60000 / SCANNER_ANIMATION_SPEED;
+    long     fadeFrames = 0;
+    uint64_t fadeNanos  = 0;
+    uint64_t otherNanos = 0;
+    for (long f = 0; f < crossfadeLength; f++)
+    {
+      hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+      BenchClock::time_point start = BenchClock::now();
+      crossfade10000::ce3kScanner();
+      uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+      if (crossfade10000::ce3kMainScanner.crossfading) { fadeFrames++; fadeNanos += nanos; }
+      else                             { otherNanos += nanos; }
+    }
+    printf("Crossfade (%d ms), 10000 LEDs: %.0f ns/frame while crossfading, %.0f ns/frame otherwise, %ld of %ld frames crossfading\n",
+           1000, fadeFrames ? (double)fadeNanos / fadeFrames : 0.0,
+           (double)otherNanos / (crossfadeLength - fadeFrames), fadeFrames, crossfadeLength);
+  }
+
+  // Several scanners: the 10000 LED strand split into eight rings of 1250
+  // LEDs, each one a separate scanner with its own pattern and flashes,
+  // updated together with ce3kUpdateScanners().
+  {
+    using namespace strand10000;
+    static CE3Kscanner rings[8];
+    for (int r = 0; r < 8; r++)
+    {
+      rings[r].setup(&leds[r * 1250], 1250, r % NUM_CE3K_PATTERNS, 1337 + r);
+    }
+    BenchClock::time_point start = BenchClock::now();
+    for (long f = 0; f < frames; f++)
+    {
+      hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+      ce3kUpdateScanners(rings, 8);
+      for (int r = 0; r < 8; r++) { rings[r].clearDirty(); }
+    }
+    uint64_t totalNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+    printf("Eight scanners of 1250 LEDs, 10000 LEDs: %.0f ns/frame, %u bytes of state per scanner\n",
+           (double)totalNanos / frames, (unsigned)sizeof(CE3Kscanner));
+  }
+
+  benchmarkBlendKernel();
+  benchmarkRgbwHelpers();
+  if (!benchmarkRenderEngine(frames))
+  {
+    printf("\nThe render engine's output depends on the number of threads\n");
+    return 1;
+  }
+  static sync400::CE3Kscanner     syncScanners[2];
+  static syncfade400::CE3Kscanner syncFadeScanners[2];
+  static CRGBW                    syncLeds[400];
+  if (!checkSync("", syncScanners[0], syncScanners[1], sync400::leds, syncLeds) ||
+      !checkSync(" with crossfades", syncFadeScanners[0], syncFadeScanners[1], syncfade400::leds, syncLeds) ||
+      !checkSyncWithoutEpochs())
+  {
+    printf("\nA scanner which was synced or sought doesn't play the same frames\n");
+    return 1;
+  }
+  if (!checkOverload())
+  {
+    printf("\nThe scanner doesn't go into reduced quality only when frames keep running late\n");
+    return 1;
+  }
+  if (!benchmarkFrameRecording())
+  {
+    printf("\nThe frame recording doesn't play back the frames that were recorded\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,490 @@
+// ---------------------------------------------------------------------------
+// Host_Frame_Recording.h
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Frame recorder and player for the Close Encounters Mothership Scanner, for
+// controllers which are too slow to render the scanner live. A PC renders a
+// long run of frames ahead of time (for example every pattern in the
+// rotation, with the conversation flashes), the recorder saves them to a
+// file, and the controller just plays the file back. The player maps the
+// whole file into memory, and hands the pixels to the LED driver straight
+// out of the mapping, so playing a frame doesn't copy anything.
+//
+// The file is little-endian, as on every PC and Raspberry Pi, and is laid out
+// like this, with everything starting on an 8-byte boundary:
+//
+//   HostFrameFileHeader   Which pixel type, how many LEDs, how many frames,
+//                         the milliseconds between frames, and where the
+//                         index is.
+//   Frame records         One per distinct frame, in one of the encodings
+//                         below.
+//   HostFrameIndexEntry   One per frame, giving the encoding, position and
+//                         size of that frame's record. Frames which are the
+//                         same as the frame before them share its record.
+//
+// Every record is complete on its own, so seeking to any frame, or to any
+// time, is a single lookup in the index. The encodings are:
+//
+//   HOST_FRAME_RAW   Every pixel of the strand.
+//
+//   HOST_FRAME_SLIT  The slit view, which is repeated along the whole strand,
+//                    plus a list of runs of pixels that don't match the slit,
+//                    which are the conversation flashes. This is a
+//                    HostFrameSlitHeader, then its HostFrameRun list, then the
+//                    slit pixels, then the pixels of each run, in order. On a
+//                    long strand it is a small fraction of the size of a raw
+//                    frame.
+//
+// The recorder picks whichever encoding is smaller for each frame. To record:
+//
+//   HostFrameRecorder<CRGBW> recorder;
+//   recorder.open("show.ce3k", NUM_LEDS, SCANNER_ANIMATION_SPEED);
+//   for (each frame)
+//   {
+//     hostAdvanceMillis(SCANNER_ANIMATION_SPEED);
+//     ce3kScanner();
+//     recorder.addFrame(leds, ce3kMainScanner.shownSlitWidth);
+//   }
+//   recorder.close();
+//
+// and to play it, pass any function or object which can be called as
+// sink(const CRGBW* pixels, uint16_t count), such as an LED driver (see
+// ce3kStreamStrand in "Close_Encounters_Mothership_Scanner.h"):
+//
+//   HostFramePlayer<CRGBW> player;
+//   player.open("show.ce3k");
+//   player.streamFrame(player.frameAt(millis()), driver);
+//
+// This file is only used by programs compiled on the PC or on a Linux-based
+// controller, never on the Arduino.
+// ---------------------------------------------------------------------------
+#ifndef Host_Frame_Recording_h
+#define Host_Frame_Recording_h
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define HOST_FRAME_MAGIC     "CE3Kfrms"
+#define HOST_FRAME_VERSION   1
+
+// Encodings of a frame record.
+#define HOST_FRAME_RAW       0
+#define HOST_FRAME_SLIT      1
+
+typedef struct
+{
+  char     Magic[8];        // HOST_FRAME_MAGIC, without the terminating zero.
+  uint32_t Version;         // HOST_FRAME_VERSION.
+  uint32_t BytesPerPixel;   // 4 for CRGBW, 3 for CRGB.
+  uint32_t NumLeds;
+  uint32_t FrameInterval;   // Milliseconds between frames.
+  uint32_t NumFrames;
+  uint32_t Reserved;
+  uint64_t IndexOffset;     // Position of the index in the file.
+} HostFrameFileHeader;
+
+typedef struct
+{
+  uint64_t Offset;          // Position of the frame's record in the file.
+  uint32_t Size;            // Size of the record in bytes.
+  uint32_t Encoding;        // One of the HOST_FRAME encodings.
+} HostFrameIndexEntry;
+
+typedef struct
+{
+  uint32_t Width;           // Number of pixels in the slit view.
+  uint32_t NumRuns;         // Number of runs of pixels which don't match the slit.
+} HostFrameSlitHeader;
+
+typedef struct
+{
+  uint32_t Start;           // First pixel of the run on the strand.
+  uint32_t Count;           // Number of pixels in the run.
+} HostFrameRun;
+
+// Records start on 8-byte boundaries.
+inline uint64_t hostFrameAlign(uint64_t size) { return (size + 7) & ~(uint64_t)7; }
+
+// ---------------------------------------------------------------------------
+// Frame recorder. Call open(), then addFrame() once per frame, then close().
+// Each of these prints what went wrong and returns false if it fails.
+// ---------------------------------------------------------------------------
+template <typename PIXEL>
+class HostFrameRecorder
+{
+public:
+  HostFrameRecorder() : File(NULL), Position(0), RawFrames(0), SlitFrames(0), RepeatedFrames(0) {}
+  ~HostFrameRecorder() { close(); }
+
+  // Start a new recording of a strand of "numLeds" pixels, one frame every
+  // "frameInterval" milliseconds.
+  bool open(const char* path, uint16_t numLeds, uint32_t frameInterval)
+  {
+    close();
+    File = fopen(path, "wb");
+    if (!File)
+    {
+      printf("Can't write %s\n", path);
+      return false;
+    }
+    memset(&Header, 0, sizeof(Header));
+    memcpy(Header.Magic, HOST_FRAME_MAGIC, sizeof(Header.Magic));
+    Header.Version       = HOST_FRAME_VERSION;
+    Header.BytesPerPixel = sizeof(PIXEL);
+    Header.NumLeds       = numLeds;
+    Header.FrameInterval = frameInterval;
+    Index.clear();
+    Previous.clear();
+    RawFrames = SlitFrames = RepeatedFrames = 0;
+
+    // The header is written again by close(), once the index is finished.
+    Position = 0;
+    return write(&Header, sizeof(Header));
+  }
+
+  // Add the next frame. "repeatWidth" is the width of the slit view which is
+  // repeated along the strand (the scanner's shownSlitWidth), or 0 to always
+  // record every pixel. It is only a hint: whatever the width, the frame is
+  // played back exactly as it was recorded.
+  bool addFrame(const PIXEL* pixels, uint16_t repeatWidth)
+  {
+    if (!File) return false;
+    uint32_t numLeds = Header.NumLeds;
+
+    // A frame which hasn't changed shares the previous frame's record.
+    if (!Index.empty() && memcmp(Previous.data(), pixels, numLeds * sizeof(PIXEL)) == 0)
+    {
+      Index.push_back(Index.back());
+      RepeatedFrames++;
+      return true;
+    }
+    Previous.assign(pixels, pixels + numLeds);
+
+    HostFrameIndexEntry entry;
+    entry.Offset = Position;
+    if (repeatWidth > 0 && repeatWidth < numLeds && encodeSlit(pixels, repeatWidth) < numLeds * sizeof(PIXEL))
+    {
+      HostFrameSlitHeader slitHeader = { repeatWidth, (uint32_t)Runs.size() };
+      entry.Encoding = HOST_FRAME_SLIT;
+      if (!write(&slitHeader, sizeof(slitHeader)) ||
+          !write(Runs.data(), Runs.size() * sizeof(HostFrameRun)) ||
+          !write(Slit.data(), repeatWidth * sizeof(PIXEL)))
+      {
+        return false;
+      }
+      for (size_t r = 0; r < Runs.size(); r++)
+      {
+        if (!write(&pixels[Runs[r].Start], Runs[r].Count * sizeof(PIXEL))) return false;
+      }
+      SlitFrames++;
+    }
+    else
+    {
+      entry.Encoding = HOST_FRAME_RAW;
+      if (!write(pixels, numLeds * sizeof(PIXEL))) return false;
+      RawFrames++;
+    }
+    entry.Size = (uint32_t)(Position - entry.Offset);
+    Index.push_back(entry);
+    return pad();
+  }
+
+  // Write the index, and fill in the header. Returns false if anything went
+  // wrong along the way.
+  bool close()
+  {
+    if (!File) return false;
+    Header.NumFrames   = (uint32_t)Index.size();
+    Header.IndexOffset = Position;
+    bool ok = write(Index.data(), Index.size() * sizeof(HostFrameIndexEntry)) &&
+              (fseek(File, 0, SEEK_SET) == 0) &&
+              (fwrite(&Header, sizeof(Header), 1, File) == 1);
+    ok &= (fclose(File) == 0);
+    File = NULL;
+    if (!ok) { printf("Error writing the frame recording\n"); }
+    return ok;
+  }
+
+  uint32_t numFrames() const      { return (uint32_t)Index.size(); }
+  uint64_t bytesWritten() const   { return Position; }
+  uint32_t rawFrames() const      { return RawFrames; }
+  uint32_t slitFrames() const     { return SlitFrames; }
+  uint32_t repeatedFrames() const { return RepeatedFrames; }
+
+private:
+  bool write(const void* data, size_t size)
+  {
+    if (size && fwrite(data, size, 1, File) != 1)
+    {
+      printf("Error writing the frame recording\n");
+      return false;
+    }
+    Position += size;
+    return true;
+  }
+
+  bool pad()
+  {
+    static const uint8_t zeros[8] = { 0 };
+    return write(zeros, hostFrameAlign(Position) - Position);
+  }
+
+  bool samePixel(const PIXEL& a, const PIXEL& b) { return memcmp(&a, &b, sizeof(PIXEL)) == 0; }
+
+  // Work out the slit view and the runs of pixels which don't match it, and
+  // return the size of the slit record.
+  uint64_t encodeSlit(const PIXEL* pixels, uint16_t width)
+  {
+    uint32_t numLeds = Header.NumLeds;
+
+    // The first copy of the slit may have a conversation flash on it, so
+    // each pixel of the slit is taken from the first copy which agrees with
+    // the copy after it.
+    Slit.resize(width);
+    for (uint32_t x = 0; x < width; x++)
+    {
+      uint32_t n = x;
+      while (n + (2 * width) < numLeds && !samePixel(pixels[n], pixels[n + width])) { n += width; }
+      Slit[x] = pixels[n];
+    }
+
+    // Runs which are only a pixel or two apart are joined together, when the
+    // pixels in between take up less room than another run would.
+    Runs.clear();
+    uint32_t runPixels = 0;
+    uint32_t column = 0;
+    for (uint32_t n = 0; n < numLeds; n++)
+    {
+      if (!samePixel(pixels[n], Slit[column]))
+      {
+        if (!Runs.empty() && (n - (Runs.back().Start + Runs.back().Count)) * sizeof(PIXEL) <= sizeof(HostFrameRun))
+        {
+          uint32_t end = Runs.back().Start + Runs.back().Count;
+          runPixels += n + 1 - end;
+          Runs.back().Count = n + 1 - Runs.back().Start;
+        }
+        else
+        {
+          HostFrameRun run = { n, 1 };
+          Runs.push_back(run);
+          runPixels++;
+        }
+      }
+      if (++column >= width) { column = 0; }
+    }
+    return sizeof(HostFrameSlitHeader) + (Runs.size() * sizeof(HostFrameRun)) + ((uint64_t)(width + runPixels) * sizeof(PIXEL));
+  }
+
+  FILE*                            File;
+  HostFrameFileHeader              Header;
+  uint64_t                         Position;
+  std::vector<HostFrameIndexEntry> Index;
+  std::vector<PIXEL>               Previous;
+  std::vector<PIXEL>               Slit;
+  std::vector<HostFrameRun>        Runs;
+  uint32_t                         RawFrames;
+  uint32_t                         SlitFrames;
+  uint32_t                         RepeatedFrames;
+};
+
+// ---------------------------------------------------------------------------
+// Frame player. The whole file is mapped into memory, and checked once by
+// open(), so that playing a frame never needs to check anything.
+// ---------------------------------------------------------------------------
+template <typename PIXEL>
+class HostFramePlayer
+{
+public:
+  HostFramePlayer() : Data(NULL), Size(0), Header(NULL), Index(NULL) {}
+  ~HostFramePlayer() { close(); }
+
+  // Map a recording into memory. Prints what is wrong with the file and
+  // returns false if it can't be played.
+  bool open(const char* path)
+  {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+      printf("Can't read %s\n", path);
+      if (fd >= 0) { ::close(fd); }
+      return false;
+    }
+    Size = status.st_size;
+    if (Size >= sizeof(HostFrameFileHeader))
+    {
+      void* data = mmap(NULL, Size, PROT_READ, MAP_SHARED, fd, 0);
+      Data = (data == MAP_FAILED) ? NULL : (const uint8_t*)data;
+    }
+    ::close(fd);   // The mapping stays valid after the file is closed.
+    if (!Data || !isValid())
+    {
+      printf("%s is not a frame recording which this player can play\n", path);
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close()
+  {
+    if (Data) { munmap((void*)Data, Size); }
+    Data   = NULL;
+    Size   = 0;
+    Header = NULL;
+    Index  = NULL;
+  }
+
+  uint32_t numFrames() const     { return Header->NumFrames; }
+  uint16_t numLeds() const       { return (uint16_t)Header->NumLeds; }
+  uint32_t frameInterval() const { return Header->FrameInterval; }
+  uint32_t encoding(uint32_t frame) const { return Index[frame].Encoding; }
+
+  // The frame to show at "time" milliseconds from the start of the
+  // recording, looping back to the start at the end.
+  uint32_t frameAt(uint32_t time) const
+  {
+    return (time / Header->FrameInterval) % Header->NumFrames;
+  }
+
+  // Hand a frame to "sink", from the first pixel to the last, as a series of
+  // runs of pixels, each of which points straight into the file's mapping.
+  template <typename SINK>
+  void streamFrame(uint32_t frame, SINK& sink) const
+  {
+    const HostFrameIndexEntry& entry = Index[frame];
+    const uint8_t* record = Data + entry.Offset;
+    uint32_t numLeds = Header->NumLeds;
+    if (entry.Encoding == HOST_FRAME_RAW)
+    {
+      streamPixels((const PIXEL*)record, numLeds, sink);
+      return;
+    }
+
+    const HostFrameSlitHeader* slitHeader = (const HostFrameSlitHeader*)record;
+    const HostFrameRun* runs  = (const HostFrameRun*)(slitHeader + 1);
+    const PIXEL* slit         = (const PIXEL*)(runs + slitHeader->NumRuns);
+    const PIXEL* runPixels    = slit + slitHeader->Width;
+    uint32_t width    = slitHeader->Width;
+    uint32_t position = 0;
+    for (uint32_t r = 0; r <= slitHeader->NumRuns; r++)
+    {
+      // Copies of the slit, up to the next run (or the end of the strand).
+      uint32_t end = (r < slitHeader->NumRuns) ? runs[r].Start : numLeds;
+      uint32_t column = position % width;
+      while (position < end)
+      {
+        uint32_t count = width - column;
+        if (count > end - position) { count = end - position; }
+        streamPixels(slit + column, count, sink);
+        position += count;
+        column = 0;
+      }
+      if (r < slitHeader->NumRuns)
+      {
+        streamPixels(runPixels, runs[r].Count, sink);
+        runPixels += runs[r].Count;
+        position  += runs[r].Count;
+      }
+    }
+  }
+
+  // Copy a frame into "destination", for drivers which can only send from a
+  // full array of pixels.
+  void expandFrame(uint32_t frame, PIXEL* destination) const
+  {
+    PIXEL* next = destination;
+    auto copier = [&](const PIXEL* pixels, uint16_t count)
+    {
+      memcpy((void*)next, pixels, count * sizeof(PIXEL));
+      next += count;
+    };
+    streamFrame(frame, copier);
+  }
+
+private:
+  // The sink takes at most 65535 pixels at a time.
+  template <typename SINK>
+  static void streamPixels(const PIXEL* pixels, uint32_t count, SINK& sink)
+  {
+    while (count > 0)
+    {
+      uint16_t part = (count > 0xFFFF) ? 0xFFFF : count;
+      sink(pixels, part);
+      pixels += part;
+      count  -= part;
+    }
+  }
+
+  // Check the header, the index, and the layout of every record, so that
+  // streamFrame() can never read outside of the file.
+  bool isValid()
+  {
+    Header = (const HostFrameFileHeader*)Data;
+    if (memcmp(Header->Magic, HOST_FRAME_MAGIC, sizeof(Header->Magic)) != 0 ||
+        Header->Version != HOST_FRAME_VERSION || Header->BytesPerPixel != sizeof(PIXEL) ||
+        Header->NumLeds == 0 || Header->NumLeds > 0xFFFF || Header->FrameInterval == 0 || Header->NumFrames == 0 ||
+        Header->IndexOffset > Size || (Header->IndexOffset & 7) != 0 ||
+        (Size - Header->IndexOffset) / sizeof(HostFrameIndexEntry) < Header->NumFrames)
+    {
+      return false;
+    }
+    Index = (const HostFrameIndexEntry*)(Data + Header->IndexOffset);
+
+    uint64_t rawSize = (uint64_t)Header->NumLeds * sizeof(PIXEL);
+    for (uint32_t f = 0; f < Header->NumFrames; f++)
+    {
+      const HostFrameIndexEntry& entry = Index[f];
+      if (entry.Offset < sizeof(HostFrameFileHeader) || (entry.Offset & 7) != 0 ||
+          entry.Offset > Header->IndexOffset || entry.Size > Header->IndexOffset - entry.Offset)
+      {
+        return false;
+      }
+      if (entry.Encoding == HOST_FRAME_RAW)
+      {
+        if (entry.Size != rawSize) return false;
+        continue;
+      }
+      if (entry.Encoding != HOST_FRAME_SLIT || entry.Size < sizeof(HostFrameSlitHeader)) return false;
+
+      // The runs must be in order, inside the strand, and along with the
+      // slit, account for exactly the size of the record.
+      const HostFrameSlitHeader* slitHeader = (const HostFrameSlitHeader*)(Data + entry.Offset);
+      if (slitHeader->Width == 0 || slitHeader->Width > Header->NumLeds ||
+          slitHeader->NumRuns > (entry.Size - sizeof(HostFrameSlitHeader)) / sizeof(HostFrameRun))
+      {
+        return false;
+      }
+      const HostFrameRun* runs = (const HostFrameRun*)(slitHeader + 1);
+      uint64_t pixels = slitHeader->Width;
+      uint32_t end = 0;
+      for (uint32_t r = 0; r < slitHeader->NumRuns; r++)
+      {
+        if (runs[r].Count == 0 || runs[r].Start < end || runs[r].Start >= Header->NumLeds ||
+            runs[r].Count > Header->NumLeds - runs[r].Start)
+        {
+          return false;
+        }
+        end = runs[r].Start + runs[r].Count;
+        pixels += runs[r].Count;
+      }
+      uint64_t size = sizeof(HostFrameSlitHeader) + ((uint64_t)slitHeader->NumRuns * sizeof(HostFrameRun)) + (pixels * sizeof(PIXEL));
+      if (entry.Size != size) return false;
+    }
+    return true;
+  }
+
+  const uint8_t*             Data;
+  size_t                     Size;
+  const HostFrameFileHeader* Header;
+  const HostFrameIndexEntry* Index;
+};
+
+#endif
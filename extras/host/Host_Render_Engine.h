@@ -0,0 +1,259 @@
+// ---------------------------------------------------------------------------
+// Host_Render_Engine.h
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Multi-threaded render engine for running the Close Encounters Mothership
+// Scanner on a Linux-based LED controller, for installations with dozens of
+// LED segments, each of which runs its own scanner (see CE3Kscanner in
+// "Close_Encounters_Mothership_Scanner.h"). A single-threaded loop() can't
+// keep up with thousands of LEDs per segment, so the engine spreads the
+// segments across a pool of worker threads.
+//
+// Each segment has its own scanner and its own pixel buffer, each in its own
+// block of memory, so the threads never write to the same cache line, and
+// nothing that the scanners write to while they render is shared between
+// segments. Each frame goes like this:
+//
+//   1. renderFrame() hands out the segments, in equal runs, one run per
+//      thread, and starts the workers. The thread which called renderFrame()
+//      is one of the workers.
+//
+//   2. Each worker renders the segments of its own run, claiming them one at
+//      a time from the front of the run. A worker which runs out of segments
+//      steals the next unclaimed segment from the front of another worker's
+//      run, so a worker which is held up (by the operating system, or by
+//      segments which happen to be slower, such as those in the middle of a
+//      crossfade) doesn't hold up the whole frame. Claiming a segment is a
+//      single atomic increment; there are no locks on the hot path.
+//
+//   3. All of the workers meet at the frame barrier, and then renderFrame()
+//      returns, with every segment's buffer finished, ready to be sent out.
+//      The workers sleep until the next frame.
+//
+// Every segment is rendered with the same "now", and each scanner only ever
+// touches its own state, so the result is exactly the same no matter how
+// many threads there are, or which thread renders which segment.
+//
+// SCANNER is the CE3Kscanner type of the scanner code, which has to be
+// included before this file. Build with "-pthread".
+//
+// This file is only used by programs compiled on the PC, never on the Arduino.
+// ---------------------------------------------------------------------------
+#ifndef Host_Render_Engine_h
+#define Host_Render_Engine_h
+
+// The profiler keeps its statistics in variables shared by every scanner,
+// which the worker threads would all write to at once.
+#if CE3K_PROFILE
+  #error "The render engine runs scanners on several threads at once, which CE3K_PROFILE doesn't support."
+#endif
+
+#include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Size of a cache line. Everything that a worker writes to during a frame is
+// aligned to this, so that two workers never fight over the same line.
+#define HOST_CACHE_LINE 64
+
+// ---------------------------------------------------------------------------
+// Reusable barrier, which each of "count" threads calls once per phase, and
+// which lets them all go once the last of them has arrived. (std::barrier
+// would do, but it needs C++20.)
+// ---------------------------------------------------------------------------
+class HostFrameBarrier
+{
+public:
+  explicit HostFrameBarrier(int count) : Count(count), Waiting(0), Generation(0) {}
+
+  void arriveAndWait()
+  {
+    std::unique_lock<std::mutex> lock(Mutex);
+    unsigned long generation = Generation;
+    if (++Waiting == Count)
+    {
+      Waiting = 0;
+      Generation++;
+      Released.notify_all();
+      return;
+    }
+    Released.wait(lock, [&] { return Generation != generation; });
+  }
+
+private:
+  std::mutex              Mutex;
+  std::condition_variable Released;
+  int                     Count;
+  int                     Waiting;
+  unsigned long           Generation;
+};
+
+// ---------------------------------------------------------------------------
+// The render engine itself. Add the segments, then call start(), and then
+// renderFrame() once per frame. If start() hasn't been called, the first
+// renderFrame() calls it.
+// ---------------------------------------------------------------------------
+template <typename SCANNER>
+class HostRenderEngine
+{
+public:
+  // Pixel type of the segments, the same as the scanner's.
+  typedef typename std::remove_pointer<decltype(SCANNER::leds)>::type Pixel;
+
+  explicit HostRenderEngine(int numThreads)
+    : NumThreads(numThreads < 1 ? 1 : numThreads), Barrier(NumThreads), Started(false), Stopping(false), FrameTime(0),
+      Queues(new WorkerQueue[NumThreads])
+  {
+  }
+
+  ~HostRenderEngine()
+  {
+    // Wake the workers up one last time, to tell them to finish.
+    if (!Workers.empty())
+    {
+      Stopping = true;
+      Barrier.arriveAndWait();
+      for (std::thread& worker : Workers) { worker.join(); }
+    }
+  }
+
+  // Add a segment of "numLeds" pixels, with its own scanner, starting on the
+  // given pattern, with the given random seed for its conversation flashes.
+  // Returns the number of the segment. Segments can only be added before
+  // start() is called, since the workers read the list of segments without
+  // any locks.
+  int addSegment(uint16_t numLeds, int patternIndex, uint16_t seed)
+  {
+    assert(!Started && "HostRenderEngine: segments must be added before start()");
+    // The buffer has a spare cache line on the end, so that the pixels of the
+    // next buffer in memory can't share a cache line with the last of these.
+    Segment* segment = new Segment();
+    segment->NumLeds = numLeds;
+    segment->Pixels.resize(numLeds + (HOST_CACHE_LINE / sizeof(Pixel)) + 1);
+    memset((void*)segment->Pixels.data(), 0, segment->Pixels.size() * sizeof(Pixel));   // Pixel types leave their values uninitialized.
+    segment->Scanner.setup(segment->Pixels.data(), numLeds, patternIndex, seed);
+    Segments.emplace_back(segment);
+    return (int)Segments.size() - 1;
+  }
+
+  // Start the worker threads. The thread which calls renderFrame() counts as
+  // one of the NumThreads threads, so one fewer than that are started.
+  // Calling it again does nothing.
+  void start()
+  {
+    if (Started) return;
+    Started = true;
+    for (int w = 1; w < NumThreads; w++)
+    {
+      Workers.emplace_back(&HostRenderEngine::workerLoop, this, w);
+    }
+  }
+
+  // Render one frame of every segment at the time "now", in milliseconds.
+  // Returns once all of the segments are finished.
+  void renderFrame(uint32_t now)
+  {
+    // The frame barrier waits for all NumThreads threads, so without the
+    // workers it would wait forever.
+    start();
+    assert(Workers.size() == (size_t)(NumThreads - 1));
+
+    // Hand out the segments in equal runs. Nothing else is running yet, and
+    // the barrier makes these writes visible to the workers.
+    FrameTime = now;
+    int count = (int)Segments.size();
+    for (int w = 0; w < NumThreads; w++)
+    {
+      Queues[w].Next.store((count * w) / NumThreads, std::memory_order_relaxed);
+      Queues[w].End = (count * (w + 1)) / NumThreads;
+    }
+
+    Barrier.arriveAndWait();   // Start the frame.
+    renderSegments(0);
+    Barrier.arriveAndWait();   // Wait for every worker to finish.
+  }
+
+  int          numSegments() const            { return (int)Segments.size(); }
+  int          numThreads() const             { return NumThreads; }
+  SCANNER&     scanner(int segment)           { return Segments[segment]->Scanner; }
+  const Pixel* pixels(int segment) const      { return Segments[segment]->Pixels.data(); }
+  uint16_t     numLeds(int segment) const     { return Segments[segment]->NumLeds; }
+
+private:
+  // One segment: its scanner, and the buffer which the scanner draws on.
+  struct alignas(HOST_CACHE_LINE) Segment
+  {
+    SCANNER            Scanner;
+    uint16_t           NumLeds;
+    std::vector<Pixel> Pixels;
+  };
+
+  // One worker's run of segments for the current frame. Next is the next
+  // unclaimed segment, and is the only thing that other workers write to,
+  // when they steal.
+  struct alignas(HOST_CACHE_LINE) WorkerQueue
+  {
+    std::atomic<int> Next;
+    int              End;
+  };
+
+  // Claim the next unclaimed segment of a worker's run. Returns -1 if there
+  // are none left. More than one worker may get past the end of the run, but
+  // only one of them can get each segment.
+  int claim(int queue)
+  {
+    WorkerQueue& q = Queues[queue];
+    if (q.Next.load(std::memory_order_relaxed) >= q.End) return -1;
+    int segment = q.Next.fetch_add(1, std::memory_order_relaxed);
+    return (segment < q.End) ? segment : -1;
+  }
+
+  // Render segments until there are none left anywhere: first the worker's
+  // own run, then whatever can be stolen from the other runs.
+  void renderSegments(int worker)
+  {
+    uint32_t now = FrameTime;
+    int segment;
+    while ((segment = claim(worker)) >= 0)
+    {
+      Segments[segment]->Scanner.update(now);
+    }
+    for (int v = 1; v < NumThreads; v++)
+    {
+      int victim = (worker + v) % NumThreads;
+      while ((segment = claim(victim)) >= 0)
+      {
+        Segments[segment]->Scanner.update(now);
+      }
+    }
+  }
+
+  void workerLoop(int worker)
+  {
+    for (;;)
+    {
+      Barrier.arriveAndWait();   // Wait for the start of a frame.
+      if (Stopping) return;
+      renderSegments(worker);
+      Barrier.arriveAndWait();   // Done with this frame.
+    }
+  }
+
+  int                                   NumThreads;
+  HostFrameBarrier                      Barrier;
+  bool                                  Started;
+  bool                                  Stopping;
+  uint32_t                              FrameTime;
+  std::unique_ptr<WorkerQueue[]>        Queues;
+  std::vector<std::unique_ptr<Segment>> Segments;
+  std::vector<std::thread>              Workers;
+};
+
+#endif
@@ -0,0 +1,100 @@
+// ---------------------------------------------------------------------------
+// Pattern packer for the Close Encounters Mothership Scanner
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Converts the one-byte-per-pixel pattern arrays defined in
+// "Close_Encounters_Mothership_Scanner.h" into the bit-packed format
+// (CE3K_FORMAT_PACKED) and the run-length format (CE3K_FORMAT_RLE), and
+// writes them out as the header file "Close_Encounters_Packed_Patterns.h",
+// which the scanner code includes. Only the copies which are used in the
+// CE3Kpatterns table take up any flash memory on the Arduino.
+//
+// In the packed format, each pixel is a single bit. Each row of the pattern
+// is stored as one or more 32-bit words, with the leftmost pixel of the row
+// in the lowest bit of the first word, and any unused bits at the end of the
+// row set to zero. Every row starts on a fresh word, so that the scanner can
+// AND together 32 pixels of ArrayA and ArrayB at a time. The encoding itself
+// is shared with the pattern compiler, see "Pattern_Encode.h".
+//
+// New patterns drawn as PGM images don't need to go through the byte arrays
+// at all; see "Compile_Patterns.cpp", which converts them directly.
+//
+// The byte arrays remain the "source" of each pattern, since they are easy
+// to read and edit by hand. After editing one of them, or adding a new one to
+// the list below, re-run this program from the top folder of the repository:
+//
+//   g++ -O2 -fpermissive -I extras/host -o pack_patterns extras/host/Pack_Patterns.cpp
+//   ./pack_patterns > Close_Encounters_Packed_Patterns.h
+// ---------------------------------------------------------------------------
+
+#include <FastLED.h>
+#include "../../FastLED_RGBW_2.h"
+
+#define NUM_LEDS 1
+bool  colorCyclingIsOn = true;
+CRGBW leds[NUM_LEDS];
+#include "../../Close_Encounters_Mothership_Scanner.h"
+#include "Pattern_Encode.h"
+
+// List of the byte arrays which will be packed. The packed version of each
+// array gets the same name with "Packed" added to the end, and the run-length
+// version gets "Rle" added to the end.
+typedef struct
+{
+  const char* Name;
+  const char* Array;
+  int         Size;
+  int         Width;
+} PackSource;
+
+static const PackSource packSources[] =
+{
+  { "arrayTony01",            arrayTony01,            arrayTony01Size,            arrayTony01Width            },
+  { "arrayTony02",            arrayTony02,            arrayTony02Size,            arrayTony02Width            },
+  { "arrayTony03",            arrayTony03,            arrayTony03Size,            arrayTony03Width            },
+  { "arrayTony04",            arrayTony04,            arrayTony04Size,            arrayTony04Width            },
+  { "arrayConversationPairs", arrayConversationPairs, arrayConversationPairsSize, arrayConversationPairsWidth },
+};
+
+int main()
+{
+  printf("// ---------------------------------------------------------------------------\n");
+  printf("// Close_Encounters_Packed_Patterns.h\n");
+  printf("//\n");
+  printf("// Bit-packed (CE3K_FORMAT_PACKED) and run-length (CE3K_FORMAT_RLE) versions\n");
+  printf("// of the pattern arrays defined in Close_Encounters_Mothership_Scanner.h. This\n");
+  printf("// file is generated by the program extras/host/Pack_Patterns.cpp; do not edit\n");
+  printf("// it by hand. See the CE3K_FORMAT values for the layout of each format. The\n");
+  printf("// Size values are in pixels, not bytes, to match the byte arrays.\n");
+  printf("//\n");
+  printf("// This file has no include guard of its own; it is included only from inside\n");
+  printf("// the include guard of Close_Encounters_Mothership_Scanner.h.\n");
+  printf("// ---------------------------------------------------------------------------\n");
+
+  for (size_t p = 0; p < sizeof(packSources) / sizeof(packSources[0]); p++)
+  {
+    const PackSource& source = packSources[p];
+    if (source.Width <= 0 || source.Size % source.Width != 0)
+    {
+      fprintf(stderr, "Error: %s size %d is not a whole number of rows of width %d.\n", source.Name, source.Size, source.Width);
+      return 1;
+    }
+
+    // The byte arrays hold 0 or 1 for each pixel; turn them into an image of
+    // brightness values for the encoder.
+    PatternImage image;
+    image.Name   = source.Name;
+    image.Width  = source.Width;
+    image.Height = source.Size / source.Width;
+    image.Pixels.resize(source.Size);
+    for (int i = 0; i < source.Size; i++)
+    {
+      image.Pixels[i] = source.Array[i] ? 255 : 0;
+    }
+    writePatternArray(stdout, image, PATTERN_FORMAT_PACKED, 128);
+    writePatternArray(stdout, image, PATTERN_FORMAT_RLE, 128);
+  }
+
+  return 0;
+}
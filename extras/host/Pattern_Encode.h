@@ -0,0 +1,202 @@
+// ---------------------------------------------------------------------------
+// Pattern_Encode.h
+//
+// https://github.com/tfabris/Close-Encounters-Mothership-Scanner
+//
+// Storage format encoders for the pattern arrays of the Close Encounters
+// Mothership Scanner, shared by the host-side pattern tools in this folder
+// (Pack_Patterns.cpp and Compile_Patterns.cpp). Each encoder takes an image
+// of brightness values, from 0 (black) to 255 (fully lit), and writes it out
+// as a PROGMEM array in one of the scanner's storage formats, followed by its
+// Size and Width constants:
+//
+//   CE3K_FORMAT_BYTES:  One byte per pixel, 0 or 1. Size is in bytes.
+//
+//   CE3K_FORMAT_PACKED: One bit per pixel. Each row of the pattern is one or
+//                       more 32-bit words, with the leftmost pixel of the row
+//                       in the lowest bit of the first word, and any unused
+//                       bits at the end of the row set to zero.
+//
+//   CE3K_FORMAT_GRAY:   One byte per pixel, a brightness level from 0 to 255.
+//
+//   CE3K_FORMAT_RLE:    Run-length encoded, one bit per pixel. The array starts
+//                       with a row index: one 16-bit little-endian offset per
+//                       row, counted in bytes from the start of the array, to
+//                       where that row's runs begin. Each row is then a list
+//                       of run lengths, one byte each, which alternate between
+//                       dark and lit pixels, starting with dark (so a row which
+//                       starts lit begins with a run of 0). A run longer than
+//                       255 pixels is written as 255, 0, and then the rest.
+//
+// For all of the formats except CE3K_FORMAT_BYTES, the Size is counted in
+// pixels, so that it is the same for every format of the same image. The
+// one-bit formats count any pixel at or above the threshold as lit.
+//
+// This file is only used by programs compiled on the PC, never on the Arduino.
+// ---------------------------------------------------------------------------
+#ifndef Pattern_Encode_h
+#define Pattern_Encode_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// An image to be encoded, as brightness values from 0 to 255, row by row.
+typedef struct
+{
+  std::string          Name;     // Name of the array, without the format suffix.
+  int                  Width;
+  int                  Height;
+  std::vector<uint8_t> Pixels;   // Width * Height brightness values.
+} PatternImage;
+
+// Storage formats, numbered the same as the CE3K_FORMAT values.
+enum PatternFormat
+{
+  PATTERN_FORMAT_BYTES  = 0,
+  PATTERN_FORMAT_PACKED = 1,
+  PATTERN_FORMAT_GRAY   = 2,
+  PATTERN_FORMAT_RLE    = 3,
+};
+
+// Suffix added to the array name, and the name of the CE3K_FORMAT value,
+// for each storage format.
+static const char* const patternFormatSuffix[] = { "", "Packed", "Gray", "Rle" };
+static const char* const patternFormatName[]   = { "CE3K_FORMAT_BYTES", "CE3K_FORMAT_PACKED", "CE3K_FORMAT_GRAY", "CE3K_FORMAT_RLE" };
+
+// ---------------------------------------------------------------------------
+// Encode the runs of one row of an image into "runs", in the
+// CE3K_FORMAT_RLE layout described at the top of this file.
+// ---------------------------------------------------------------------------
+static void encodeRleRow(const uint8_t* row, int width, uint8_t threshold, std::vector<uint8_t>& runs)
+{
+  bool lit = false;
+  int  x   = 0;
+  while (x < width)
+  {
+    int run = 0;
+    while (x < width && ((row[x] >= threshold) == lit)) { run++; x++; }
+    while (run > 255)
+    {
+      runs.push_back(255);
+      runs.push_back(0);
+      run -= 255;
+    }
+    runs.push_back((uint8_t)run);
+    lit = !lit;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Write an image as a PROGMEM array in the given format, followed by its
+// Size and Width constants. Returns the number of bytes of flash memory that
+// the array takes up.
+// ---------------------------------------------------------------------------
+static size_t writePatternArray(FILE* out, const PatternImage& image, PatternFormat format, uint8_t threshold)
+{
+  std::string name  = image.Name + patternFormatSuffix[format];
+  int         width = image.Width;
+  size_t      bytes = 0;
+
+  switch (format)
+  {
+    case PATTERN_FORMAT_BYTES:
+      fprintf(out, "\nconst char PROGMEM %s[] = \n{\n", name.c_str());
+      for (int row = 0; row < image.Height; row++)
+      {
+        fprintf(out, "  ");
+        for (int x = 0; x < width; x++)
+        {
+          fprintf(out, "%d,", (image.Pixels[(row * width) + x] >= threshold) ? 1 : 0);
+        }
+        fprintf(out, "\n");
+      }
+      bytes = (size_t)width * image.Height;
+      break;
+
+    case PATTERN_FORMAT_PACKED:
+    {
+      int wordsPerRow = (width + 31) / 32;
+      fprintf(out, "\nconst uint32_t PROGMEM %s[] = \n{\n", name.c_str());
+      for (int row = 0; row < image.Height; row++)
+      {
+        fprintf(out, " ");
+        for (int word = 0; word < wordsPerRow; word++)
+        {
+          uint32_t bits = 0;
+          for (int bit = 0; bit < 32; bit++)
+          {
+            int x = (word * 32) + bit;
+            if (x < width && image.Pixels[(row * width) + x] >= threshold)
+            {
+              bits |= (uint32_t)1 << bit;
+            }
+          }
+          fprintf(out, " 0x%08X,", bits);
+        }
+        fprintf(out, "\n");
+      }
+      bytes = (size_t)wordsPerRow * 4 * image.Height;
+      break;
+    }
+
+    case PATTERN_FORMAT_GRAY:
+      fprintf(out, "\nconst uint8_t PROGMEM %s[] = \n{\n", name.c_str());
+      for (int row = 0; row < image.Height; row++)
+      {
+        fprintf(out, "  ");
+        for (int x = 0; x < width; x++)
+        {
+          fprintf(out, "%3d,", image.Pixels[(row * width) + x]);
+        }
+        fprintf(out, "\n");
+      }
+      bytes = (size_t)width * image.Height;
+      break;
+
+    case PATTERN_FORMAT_RLE:
+    {
+      // Encode every row first, so that the offsets of the rows are known
+      // before the index is written.
+      std::vector< std::vector<uint8_t> > rows(image.Height);
+      size_t offset = (size_t)image.Height * 2;
+      for (int row = 0; row < image.Height; row++)
+      {
+        encodeRleRow(&image.Pixels[row * width], width, threshold, rows[row]);
+      }
+      fprintf(out, "\nconst uint8_t PROGMEM %s[] = \n{\n", name.c_str());
+      fprintf(out, "  // Row index.\n");
+      for (int row = 0; row < image.Height; row++)
+      {
+        if (offset > 0xFFFF)
+        {
+          fprintf(stderr, "Error: %s is too big for the 16-bit row index of the run-length format.\n", name.c_str());
+          return 0;
+        }
+        fprintf(out, "%s0x%02X,0x%02X,", (row % 8 == 0) ? "  " : " ", (unsigned)(offset & 0xFF), (unsigned)(offset >> 8));
+        if (row % 8 == 7 || row == image.Height - 1) { fprintf(out, "\n"); }
+        offset += rows[row].size();
+      }
+      fprintf(out, "  // Runs of each row, dark first.\n");
+      for (int row = 0; row < image.Height; row++)
+      {
+        fprintf(out, "  ");
+        for (size_t r = 0; r < rows[row].size(); r++)
+        {
+          fprintf(out, "%d,", rows[row][r]);
+        }
+        fprintf(out, "\n");
+      }
+      bytes = offset;
+      break;
+    }
+  }
+
+  fprintf(out, "};\n");
+  fprintf(out, "const int %sSize = %d;\n", name.c_str(), width * image.Height);
+  fprintf(out, "const int %sWidth = %d;\n", name.c_str(), width);
+  return bytes;
+}
+
+#endif